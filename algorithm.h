@@ -1,185 +1,722 @@
-﻿#pragma once
-#include <functional>
-#include "Iterator.h"
-
-namespace mystd {
-
-
-template<typename InputIterator, typename Cmp>
-void quickSort(InputIterator begin, InputIterator end, Cmp cmp) {
-    if (begin >= end)
-        return;
-    using value_type = typename iterator_traits<InputIterator>::value_type;
-    using std::swap;
-
-    InputIterator i = begin, j = --end;
-    value_type pivot = *begin;
-    while (i < j) {
-        while (i < j && cmp(pivot, *j)) { --j; }
-        while (i < j && !cmp(pivot, *i)) { ++i; }
-        if (i < j)
-            swap(*i, *j);
-    }
-    swap(*begin, *i);
-
-    quickSort(begin, i, cmp);
-    quickSort(++i, ++end, cmp);
-}
-
-template <typename InputIterator>
-void quickSort(InputIterator begin, InputIterator end) {
-    using value_type = typename iterator_traits<InputIterator>::value_type;
-    quickSort(begin, end, std::less<value_type>());
-}
-
-
-template <typename T> 
-constexpr const T& max(const T& a, const T& b) {
-    return a < b ? b : a;
-}
-
-
-
-
-template <typename InputIterator, typename T>
-InputIterator find(InputIterator begin, InputIterator end, const T& value) {
-    while (begin != end && *begin != value)
-        ++begin;
-    return begin;
-}
-
-
-
-//heap
-/*
-Given a heap in the range[first, last - 1),
-this function extends the range considered a heap to [first,last) 
-by placing the value in (last-1) into its corresponding location within it.
-*/
-template <typename RandomAccessIterator, typename Compare>
-void push_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-
-    if (last - first < 2) return;
-
-    value_type elem = *(last - 1);
-    auto elem_idx = last - first - 1;
-    using idx_type = decltype(elem_idx);
-    idx_type root_idx = 0;
-    idx_type parent_idx = (elem_idx - 1) / 2;
-
-    while (elem_idx > root_idx && comp(*(first + parent_idx), elem)){
-        *(first + elem_idx) = *(first + parent_idx);
-        elem_idx = parent_idx;
-        parent_idx = (elem_idx - 1) / 2;
-    }
-    *(first + elem_idx) = elem;
-}
-
-
-template <typename RandomAccessIterator>
-void push_heap(RandomAccessIterator first, RandomAccessIterator last){
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-    mystd::push_heap(first, last, std::less<value_type>());
-}
-
-
-template <typename RandomAccessIterator, typename Distance, typename Compare>
-void fix_down(RandomAccessIterator beg, Distance size, Distance start_idx, Compare comp){
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-
-    value_type elem = *(beg + start_idx);
-    Distance node_idx = start_idx;
-    Distance right_child = start_idx;
-
-    while (right_child * 2 + 2 < size){
-        right_child = 2 * right_child + 2;
-
-        if (comp(*(beg + right_child), *(beg + right_child - 1))){
-            --right_child;
-        }
-        if (!comp(elem, *(beg + right_child))){
-            break;
-        }
-
-        *(beg + node_idx) = *(beg + right_child);
-        node_idx = right_child;
-    }
-
-    if (right_child * 2 + 2 == size){
-        right_child = 2 * right_child + 1;
-        if (comp(elem, *(beg + right_child))){
-            *(beg + node_idx) = *(beg + right_child);
-            node_idx = right_child;
-        }
-    }
-    *(beg + node_idx) = elem;
-}
-
-template <typename RandomAccessIterator, typename Distance>
-void fix_down(RandomAccessIterator beg, Distance size, Distance start_idx){
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-    mystd::fix_down(beg, size, start_idx, std::less<value_type>());
-}
-
-
-template <typename RandomAccessIterator, typename Compare>
-void pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
-    if (last - first < 2){
-        return;
-    }
-    std::swap(*first, *(--last));
-    auto size = last - first;
-    decltype(size) index = 0;
-    mystd::fix_down(first, size, index, comp);
-}
-
-
-template <typename RandomAccessIterator>
-void pop_heap(RandomAccessIterator first, RandomAccessIterator last){
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-    mystd::pop_heap(first, last, std::less<value_type>());
-}
-
-
-template <typename RandomAccessIterator, typename Compare>
-void make_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp){
-    if (last - first < 2) {
-        return;
-    }
-    auto size = last - first;
-    auto last_idx = size - 1;
-    for (auto index = (last_idx - 1) / 2; index >= 0; --index)
-    {
-        mystd::fix_down(first, size, index, comp);
-    }
-}
-
-
-template <typename RandomAccessIterator>
-void make_heap(RandomAccessIterator first, RandomAccessIterator last){
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-    mystd::make_heap(first, last, std::less<value_type>());
-}
-
-
-template<typename RandomAccessIterator, typename Compare>
-void sort_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp){
-    while (last - first > 1){
-        mystd::pop_heap(first, last--, comp);
-    }
-}
-
-template<typename RandomAccessIterator>
-void sort_heap(RandomAccessIterator first, RandomAccessIterator last){
-    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
-    mystd::sort_heap(first, last, std::less<value_type>());
-}
-
-
-
-
-
-
-
+﻿#pragma once
+#include <functional>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <type_traits>
+#include "iterator.h"
+#include "vector.h"
+#include "simd.h"
+
+namespace mystd {
+
+
+template <typename T> 
+constexpr const T& max(const T& a, const T& b) {
+    return a < b ? b : a;
+}
+
+
+
+
+//raw pointers to integers, enums or pointers compared with a value of the same type use the SIMD kernels
+template <typename Iterator, typename T>
+struct is_simd_searchable : std::integral_constant<bool,
+    std::is_pointer<Iterator>::value &&
+    std::is_same<typename std::remove_cv<typename std::remove_pointer<Iterator>::type>::type, T>::value &&
+    is_simd_comparable<T>::value> {};
+
+template <typename InputIterator, typename T>
+InputIterator find(InputIterator begin, InputIterator end, const T& value, std::false_type) {
+    while (begin != end && *begin != value)
+        ++begin;
+    return begin;
+}
+
+template <typename Pointer, typename T>
+Pointer find(Pointer begin, Pointer end, const T& value, std::true_type) {
+    return begin + (mystd::simd_find<T>(begin, end, value) - begin);
+}
+
+template <typename InputIterator, typename T>
+InputIterator find(InputIterator begin, InputIterator end, const T& value) {
+    return mystd::find(begin, end, value,
+        std::integral_constant<bool, is_simd_searchable<InputIterator, T>::value>());
+}
+
+
+template <typename InputIterator, typename T>
+typename iterator_traits<InputIterator>::difference_type
+count(InputIterator begin, InputIterator end, const T& value, std::false_type) {
+    typename iterator_traits<InputIterator>::difference_type n = 0;
+    for (; begin != end; ++begin) {
+        if (*begin == value)
+            ++n;
+    }
+    return n;
+}
+
+template <typename Pointer, typename T>
+std::ptrdiff_t count(Pointer begin, Pointer end, const T& value, std::true_type) {
+    return mystd::simd_count<T>(begin, end, value);
+}
+
+template <typename InputIterator, typename T>
+typename iterator_traits<InputIterator>::difference_type count(InputIterator begin, InputIterator end, const T& value) {
+    return mystd::count(begin, end, value,
+        std::integral_constant<bool, is_simd_searchable<InputIterator, T>::value>());
+}
+
+
+template <typename InputIterator1, typename InputIterator2>
+std::pair<InputIterator1, InputIterator2>
+mismatch(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, std::false_type) {
+    while (first1 != last1 && *first1 == *first2) {
+        ++first1;
+        ++first2;
+    }
+    return std::make_pair(first1, first2);
+}
+
+template <typename Pointer1, typename Pointer2>
+std::pair<Pointer1, Pointer2> mismatch(Pointer1 first1, Pointer1 last1, Pointer2 first2, std::true_type) {
+    using value_type = typename std::remove_cv<typename std::remove_pointer<Pointer1>::type>::type;
+    const std::ptrdiff_t offset = mystd::simd_mismatch<value_type>(first1, last1, first2);
+    return std::make_pair(first1 + offset, first2 + offset);
+}
+
+//the range at first2 must be at least as long as [first1, last1)
+template <typename InputIterator1, typename InputIterator2>
+std::pair<InputIterator1, InputIterator2> mismatch(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2) {
+    using value_type = typename iterator_traits<InputIterator1>::value_type;
+    return mystd::mismatch(first1, last1, first2, std::integral_constant<bool,
+        is_simd_searchable<InputIterator1, value_type>::value && is_simd_searchable<InputIterator2, value_type>::value>());
+}
+
+template <typename InputIterator1, typename InputIterator2>
+bool equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2) {
+    return mystd::mismatch(first1, last1, first2).first == last1;
+}
+
+
+
+//binary search
+/*
+Branchless search over a sorted random-access range. Every step halves len and
+moves first by a select instead of a jump, which compiles to cmov, so there are
+no mispredicted branches; the loop always runs ceil(log2(n)) times.
+*/
+template <typename RandomAccessIterator, typename T, typename Compare>
+RandomAccessIterator lower_bound(RandomAccessIterator first, RandomAccessIterator last, const T& value, Compare comp) {
+    using Distance = typename iterator_traits<RandomAccessIterator>::difference_type;
+    Distance len = last - first;
+    if (len == 0)
+        return first;
+    while (len > 1) {
+        const Distance half = len / 2;
+        first += comp(*(first + (half - 1)), value) ? half : 0;
+        len -= half;
+    }
+    return first + (comp(*first, value) ? 1 : 0);
+}
+
+template <typename RandomAccessIterator, typename T>
+RandomAccessIterator lower_bound(RandomAccessIterator first, RandomAccessIterator last, const T& value) {
+    return mystd::lower_bound(first, last, value, std::less<T>());
+}
+
+template <typename RandomAccessIterator, typename T, typename Compare>
+RandomAccessIterator upper_bound(RandomAccessIterator first, RandomAccessIterator last, const T& value, Compare comp) {
+    using Distance = typename iterator_traits<RandomAccessIterator>::difference_type;
+    Distance len = last - first;
+    if (len == 0)
+        return first;
+    while (len > 1) {
+        const Distance half = len / 2;
+        first += comp(value, *(first + (half - 1))) ? 0 : half;
+        len -= half;
+    }
+    return first + (comp(value, *first) ? 0 : 1);
+}
+
+template <typename RandomAccessIterator, typename T>
+RandomAccessIterator upper_bound(RandomAccessIterator first, RandomAccessIterator last, const T& value) {
+    return mystd::upper_bound(first, last, value, std::less<T>());
+}
+
+template <typename RandomAccessIterator, typename T, typename Compare>
+bool binary_search(RandomAccessIterator first, RandomAccessIterator last, const T& value, Compare comp) {
+    first = mystd::lower_bound(first, last, value, comp);
+    return first != last && !comp(value, *first);
+}
+
+template <typename RandomAccessIterator, typename T>
+bool binary_search(RandomAccessIterator first, RandomAccessIterator last, const T& value) {
+    return mystd::binary_search(first, last, value, std::less<T>());
+}
+
+
+
+//heap
+/*
+Given a heap in the range[first, last - 1),
+this function extends the range considered a heap to [first,last) 
+by placing the value in (last-1) into its corresponding location within it.
+*/
+template <typename RandomAccessIterator, typename Compare>
+void push_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+    if (last - first < 2) return;
+
+    value_type elem = std::move(*(last - 1));
+    auto elem_idx = last - first - 1;
+    using idx_type = decltype(elem_idx);
+    idx_type root_idx = 0;
+    idx_type parent_idx = (elem_idx - 1) / 2;
+
+    while (elem_idx > root_idx && comp(*(first + parent_idx), elem)){
+        *(first + elem_idx) = std::move(*(first + parent_idx));
+        elem_idx = parent_idx;
+        parent_idx = (elem_idx - 1) / 2;
+    }
+    *(first + elem_idx) = std::move(elem);
+}
+
+
+template <typename RandomAccessIterator>
+void push_heap(RandomAccessIterator first, RandomAccessIterator last){
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::push_heap(first, last, std::less<value_type>());
+}
+
+
+template <typename RandomAccessIterator, typename Distance, typename Compare>
+void fix_down(RandomAccessIterator beg, Distance size, Distance start_idx, Compare comp){
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+    value_type elem = std::move(*(beg + start_idx));
+    Distance node_idx = start_idx;
+    Distance right_child = start_idx;
+
+    while (right_child * 2 + 2 < size){
+        right_child = 2 * right_child + 2;
+
+        if (comp(*(beg + right_child), *(beg + right_child - 1))){
+            --right_child;
+        }
+        if (!comp(elem, *(beg + right_child))){
+            break;
+        }
+
+        *(beg + node_idx) = std::move(*(beg + right_child));
+        node_idx = right_child;
+    }
+
+    if (right_child * 2 + 2 == size){
+        right_child = 2 * right_child + 1;
+        if (comp(elem, *(beg + right_child))){
+            *(beg + node_idx) = std::move(*(beg + right_child));
+            node_idx = right_child;
+        }
+    }
+    *(beg + node_idx) = std::move(elem);
+}
+
+template <typename RandomAccessIterator, typename Distance>
+void fix_down(RandomAccessIterator beg, Distance size, Distance start_idx){
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::fix_down(beg, size, start_idx, std::less<value_type>());
+}
+
+
+template <typename RandomAccessIterator, typename Compare>
+void pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    if (last - first < 2){
+        return;
+    }
+    std::swap(*first, *(--last));
+    auto size = last - first;
+    decltype(size) index = 0;
+    mystd::fix_down(first, size, index, comp);
+}
+
+
+template <typename RandomAccessIterator>
+void pop_heap(RandomAccessIterator first, RandomAccessIterator last){
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::pop_heap(first, last, std::less<value_type>());
+}
+
+
+template <typename RandomAccessIterator, typename Compare>
+void make_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp){
+    if (last - first < 2) {
+        return;
+    }
+    auto size = last - first;
+    auto last_idx = size - 1;
+    for (auto index = (last_idx - 1) / 2; index >= 0; --index)
+    {
+        mystd::fix_down(first, size, index, comp);
+    }
+}
+
+
+template <typename RandomAccessIterator>
+void make_heap(RandomAccessIterator first, RandomAccessIterator last){
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::make_heap(first, last, std::less<value_type>());
+}
+
+
+template<typename RandomAccessIterator, typename Compare>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp){
+    while (last - first > 1){
+        mystd::pop_heap(first, last--, comp);
+    }
+}
+
+template<typename RandomAccessIterator>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last){
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::sort_heap(first, last, std::less<value_type>());
+}
+
+
+/*
+d-ary heap: the children of node i are Arity * i + 1 ... Arity * i + Arity.
+A wider node makes the tree log2(Arity) times shallower, and the children of a node are
+adjacent in memory, so a pop touches fewer cache lines on large heaps at the price of
+more comparisons per level. Arity 2 is the binary heap above.
+*/
+template <std::size_t Arity, typename RandomAccessIterator, typename Compare>
+void dary_push_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    using Distance = typename iterator_traits<RandomAccessIterator>::difference_type;
+
+    if (last - first < 2) return;
+
+    value_type elem = std::move(*(last - 1));
+    Distance elem_idx = last - first - 1;
+    while (elem_idx > 0) {
+        const Distance parent_idx = (elem_idx - 1) / static_cast<Distance>(Arity);
+        if (!comp(*(first + parent_idx), elem))
+            break;
+        *(first + elem_idx) = std::move(*(first + parent_idx));
+        elem_idx = parent_idx;
+    }
+    *(first + elem_idx) = std::move(elem);
+}
+
+//the greatest of the children [child, child + Arity) that lie below size
+template <std::size_t Arity, typename RandomAccessIterator, typename Distance, typename Compare>
+Distance dary_max_child(RandomAccessIterator beg, Distance size, Distance child, Compare comp) {
+    Distance max_child = child;
+    if (size - child >= static_cast<Distance>(Arity)) {
+        //a full node: a fixed trip count the compiler unrolls into selects
+        for (std::size_t i = 1; i < Arity; ++i) {
+            const Distance next = child + static_cast<Distance>(i);
+            max_child = comp(*(beg + max_child), *(beg + next)) ? next : max_child;
+        }
+    }
+    else {
+        for (++child; child < size; ++child)
+            max_child = comp(*(beg + max_child), *(beg + child)) ? child : max_child;
+    }
+    return max_child;
+}
+
+template <std::size_t Arity, typename RandomAccessIterator, typename Distance, typename Compare>
+void dary_fix_down(RandomAccessIterator beg, Distance size, Distance start_idx, Compare comp) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+    value_type elem = std::move(*(beg + start_idx));
+    Distance node_idx = start_idx;
+    Distance child = node_idx * static_cast<Distance>(Arity) + 1;
+    while (child < size) {
+        const Distance max_child = mystd::dary_max_child<Arity>(beg, size, child, comp);
+        if (!comp(elem, *(beg + max_child)))
+            break;
+
+        *(beg + node_idx) = std::move(*(beg + max_child));
+        node_idx = max_child;
+        child = node_idx * static_cast<Distance>(Arity) + 1;
+    }
+    *(beg + node_idx) = std::move(elem);
+}
+
+/*
+The element taken from the back is usually among the smallest, so instead of comparing it
+at every level the hole left by the top walks down to a leaf along the greatest children,
+and the element is then pushed up from there, which rarely takes more than a step or two.
+*/
+template <std::size_t Arity, typename RandomAccessIterator, typename Compare>
+void dary_pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    using Distance = typename iterator_traits<RandomAccessIterator>::difference_type;
+
+    if (last - first < 2){
+        return;
+    }
+    --last;
+    value_type elem = std::move(*last);
+    *last = std::move(*first);
+    const Distance size = last - first;
+
+    Distance hole = 0;
+    Distance child = 1;
+    while (child < size) {
+        //the grandchildren form one contiguous block; load it while the children are compared
+        const Distance grandchild = child * static_cast<Distance>(Arity) + 1;
+        if (grandchild < size)
+            mystd::prefetch(std::addressof(*(first + grandchild)));
+        const Distance max_child = mystd::dary_max_child<Arity>(first, size, child, comp);
+        *(first + hole) = std::move(*(first + max_child));
+        hole = max_child;
+        child = hole * static_cast<Distance>(Arity) + 1;
+    }
+    *(first + hole) = std::move(elem);
+    mystd::dary_push_heap<Arity>(first, first + (hole + 1), comp);
+}
+
+template <std::size_t Arity, typename RandomAccessIterator, typename Compare>
+void dary_make_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    if (last - first < 2) {
+        return;
+    }
+    auto size = last - first;
+    for (auto index = (size - 2) / static_cast<decltype(size)>(Arity); index >= 0; --index)
+        mystd::dary_fix_down<Arity>(first, size, index, comp);
+}
+
+//heap shape policy of priority_queue
+template <std::size_t Arity>
+struct dary_heap {
+    static_assert(Arity >= 2, "a heap node needs at least 2 children");
+
+    template <typename RandomAccessIterator, typename Compare>
+    static void push(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+        mystd::dary_push_heap<Arity>(first, last, comp);
+    }
+
+    template <typename RandomAccessIterator, typename Compare>
+    static void pop(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+        mystd::dary_pop_heap<Arity>(first, last, comp);
+    }
+
+    template <typename RandomAccessIterator, typename Compare>
+    static void make(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+        mystd::dary_make_heap<Arity>(first, last, comp);
+    }
+};
+
+template <>
+struct dary_heap<2> {
+    template <typename RandomAccessIterator, typename Compare>
+    static void push(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+        mystd::push_heap(first, last, comp);
+    }
+
+    template <typename RandomAccessIterator, typename Compare>
+    static void pop(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+        mystd::pop_heap(first, last, comp);
+    }
+
+    template <typename RandomAccessIterator, typename Compare>
+    static void make(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+        mystd::make_heap(first, last, comp);
+    }
+};
+
+using binary_heap = dary_heap<2>;
+
+
+//sort
+//ranges no longer than this are finished by insertion sort
+const long SORT_THRESHOLD = 16;
+//ranges longer than this take the pivot as the median of three medians (ninther)
+const long NINTHER_THRESHOLD = 128;
+
+template <typename RandomAccessIterator, typename Compare>
+void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    if (last - first < 2)
+        return;
+
+    for (RandomAccessIterator i = first + 1; i != last; ++i) {
+        value_type elem = std::move(*i);
+        RandomAccessIterator hole = i;
+        //a new minimum goes straight to the front, others stop at an element not greater than them
+        if (comp(elem, *first)) {
+            for (; hole != first; --hole)
+                *hole = std::move(*(hole - 1));
+        }
+        else {
+            for (; comp(elem, *(hole - 1)); --hole)
+                *hole = std::move(*(hole - 1));
+        }
+        *hole = std::move(elem);
+    }
+}
+
+template <typename RandomAccessIterator>
+void insertion_sort(RandomAccessIterator first, RandomAccessIterator last) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::insertion_sort(first, last, std::less<value_type>());
+}
+
+//reorder *a, *b, *c so that *a <= *b <= *c
+template <typename RandomAccessIterator, typename Compare>
+void sort3(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator c, Compare comp) {
+    using std::swap;
+    if (comp(*b, *a))
+        swap(*a, *b);
+    if (comp(*c, *b)) {
+        swap(*b, *c);
+        if (comp(*b, *a))
+            swap(*a, *b);
+    }
+}
+
+/*
+Partition [first, last) around *pivot, which lies outside the range.
+Both scans stop at elements equal to the pivot, so many duplicates still split evenly.
+The range must hold an element not less and an element not greater than the pivot,
+they stop the scans without bound checks.
+*/
+template <typename RandomAccessIterator, typename Compare>
+RandomAccessIterator unguarded_partition(RandomAccessIterator first, RandomAccessIterator last,
+    RandomAccessIterator pivot, Compare comp) {
+    using std::swap;
+    while (true) {
+        while (comp(*first, *pivot))
+            ++first;
+        --last;
+        while (comp(*pivot, *last))
+            --last;
+        if (!(first < last))
+            return first;
+        swap(*first, *last);
+        ++first;
+    }
+}
+
+//move a median pivot to *first and partition the rest around it
+template <typename RandomAccessIterator, typename Compare>
+RandomAccessIterator partition_pivot(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    using std::swap;
+    auto size = last - first;
+    RandomAccessIterator mid = first + size / 2;
+    if (size > NINTHER_THRESHOLD) {
+        mystd::sort3(first, mid, last - 1, comp);
+        mystd::sort3(first + 1, mid - 1, last - 2, comp);
+        mystd::sort3(first + 2, mid + 1, last - 3, comp);
+        mystd::sort3(mid - 1, mid, mid + 1, comp);
+    }
+    else {
+        mystd::sort3(first, mid, last - 1, comp);
+    }
+    //the smaller and the greater candidates stay in the range as sentinels
+    swap(*first, *mid);
+    return mystd::unguarded_partition(first + 1, last, first, comp);
+}
+
+template <typename RandomAccessIterator, typename Distance, typename Compare>
+void introsort_loop(RandomAccessIterator first, RandomAccessIterator last, Distance depth_limit, Compare comp) {
+    while (last - first > SORT_THRESHOLD) {
+        //too many bad pivots, heapsort keeps the worst case at O(n log n)
+        if (depth_limit == 0) {
+            mystd::make_heap(first, last, comp);
+            mystd::sort_heap(first, last, comp);
+            return;
+        }
+        --depth_limit;
+
+        RandomAccessIterator cut = mystd::partition_pivot(first, last, comp);
+        //recurse into the smaller side and loop on the larger one, so the stack stays O(log n)
+        if (cut - first < last - cut) {
+            mystd::introsort_loop(first, cut, depth_limit, comp);
+            first = cut;
+        }
+        else {
+            mystd::introsort_loop(cut, last, depth_limit, comp);
+            last = cut;
+        }
+    }
+    mystd::insertion_sort(first, last, comp);
+}
+
+template <typename RandomAccessIterator, typename Compare>
+void sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    auto size = last - first;
+    if (size < 2)
+        return;
+    decltype(size) depth_limit = 0;
+    for (auto n = size; n > 1; n >>= 1)
+        depth_limit += 2;
+    mystd::introsort_loop(first, last, depth_limit, comp);
+}
+
+template <typename RandomAccessIterator>
+void sort(RandomAccessIterator first, RandomAccessIterator last) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::sort(first, last, std::less<value_type>());
+}
+
+//radix sort
+/*
+radix_traits<Key>::encode maps a key to an unsigned integer of the same width
+whose unsigned order is the order of the keys:
+signed integers get their sign bit flipped, and IEEE floats get all bits flipped when negative,
+only the sign bit otherwise. So -0.0 sorts before +0.0 and NaNs sort by their bits,
+below every other value when negative and above it when positive.
+Specialize it to radix sort your own key types.
+*/
+template <typename Key, typename = void>
+struct radix_traits;
+
+template <typename Key>
+struct radix_traits<Key, typename std::enable_if<std::is_integral<Key>::value && std::is_unsigned<Key>::value>::type> {
+    using type = Key;
+    static type encode(Key key) noexcept {
+        return key;
+    }
+};
+
+template <typename Key>
+struct radix_traits<Key, typename std::enable_if<std::is_integral<Key>::value && std::is_signed<Key>::value>::type> {
+    using type = typename std::make_unsigned<Key>::type;
+    static type encode(Key key) noexcept {
+        return static_cast<type>(static_cast<type>(key) ^ (type(1) << (sizeof(type) * CHAR_BIT - 1)));
+    }
+};
+
+template <typename Key>
+struct radix_traits<Key, typename std::enable_if<std::is_floating_point<Key>::value &&
+    (sizeof(Key) == sizeof(std::uint32_t) || sizeof(Key) == sizeof(std::uint64_t))>::type> {
+    using type = typename std::conditional<sizeof(Key) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>::type;
+    static type encode(Key key) noexcept {
+        type bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        const type sign = type(1) << (sizeof(type) * CHAR_BIT - 1);
+        return (bits & sign) ? ~bits : (bits | sign);
+    }
+};
+
+//ranges shorter than this are insertion sorted, which is stable as well
+const long RADIX_SORT_THRESHOLD = 64;
+const int RADIX_BITS = 8;
+const std::size_t RADIX_BUCKETS = std::size_t(1) << RADIX_BITS;
+
+template <typename Value>
+struct radix_value_encoder {
+    typename radix_traits<Value>::type operator()(const Value& value) const {
+        return radix_traits<Value>::encode(value);
+    }
+};
+
+template <typename Value, typename KeyFunction>
+struct radix_key_encoder {
+    using key_type = typename std::decay<decltype(std::declval<KeyFunction&>()(std::declval<const Value&>()))>::type;
+
+    mutable KeyFunction key_fn;
+
+    typename radix_traits<key_type>::type operator()(const Value& value) const {
+        return radix_traits<key_type>::encode(key_fn(value));
+    }
+};
+
+//stable scatter of [first, last) into dst by the digit at shift
+template <typename InputIterator, typename OutputIterator, typename Encoder>
+void radix_scatter(InputIterator first, InputIterator last, OutputIterator dst,
+    const std::size_t* counts, int shift, Encoder& encode) {
+    std::size_t offsets[RADIX_BUCKETS];
+    std::size_t sum = 0;
+    for (std::size_t d = 0; d < RADIX_BUCKETS; ++d) {
+        offsets[d] = sum;
+        sum += counts[d];
+    }
+    for (; first != last; ++first) {
+        const std::size_t digit = (encode(*first) >> shift) & (RADIX_BUCKETS - 1);
+        *(dst + offsets[digit]++) = std::move(*first);
+    }
+}
+
+//LSD radix sort on the unsigned keys produced by encode, one byte per pass
+template <typename RandomAccessIterator, typename Encoder>
+void radix_sort_encoded(RandomAccessIterator first, RandomAccessIterator last, Encoder encode) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    using key_type = typename std::decay<decltype(encode(*first))>::type;
+    const int PASSES = sizeof(key_type) * CHAR_BIT / RADIX_BITS;
+
+    const auto size = last - first;
+    if (size < RADIX_SORT_THRESHOLD) {
+        mystd::insertion_sort(first, last,
+            [&encode](const value_type& a, const value_type& b) { return encode(a) < encode(b); });
+        return;
+    }
+
+    //histograms of every digit in a single read of the keys
+    std::size_t counts[PASSES][RADIX_BUCKETS] = {};
+    for (RandomAccessIterator it = first; it != last; ++it) {
+        const key_type key = encode(*it);
+        for (int pass = 0; pass < PASSES; ++pass)
+            ++counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+    }
+
+    //a digit shared by every key leaves the order as it is, so its pass is skipped
+    int live[PASSES];
+    int live_cnt = 0;
+    for (int pass = 0; pass < PASSES; ++pass) {
+        const key_type digit = (encode(*first) >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+        if (counts[pass][digit] != static_cast<std::size_t>(size))
+            live[live_cnt++] = pass;
+    }
+    if (live_cnt == 0)
+        return;
+
+    mystd::vector<value_type> buffer;
+    buffer.reserve(size);
+    buffer.insert(buffer.end(), std::make_move_iterator(first), std::make_move_iterator(last));
+    bool in_buffer = true;
+    for (int i = 0; i < live_cnt; ++i) {
+        const int pass = live[i];
+        if (in_buffer)
+            mystd::radix_scatter(buffer.begin(), buffer.end(), first, counts[pass], pass * RADIX_BITS, encode);
+        else
+            mystd::radix_scatter(first, last, buffer.begin(), counts[pass], pass * RADIX_BITS, encode);
+        in_buffer = !in_buffer;
+    }
+    if (in_buffer)
+        std::move(buffer.begin(), buffer.end(), first);
+}
+
+//stable ascending sort of integers or floats
+template <typename RandomAccessIterator>
+void radix_sort(RandomAccessIterator first, RandomAccessIterator last) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::radix_sort_encoded(first, last, radix_value_encoder<value_type>());
+}
+
+//stable ascending sort of records by the integer or float key_fn(record)
+template <typename RandomAccessIterator, typename KeyFunction>
+void radix_sort_by_key(RandomAccessIterator first, RandomAccessIterator last, KeyFunction key_fn) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::radix_sort_encoded(first, last, radix_key_encoder<value_type, KeyFunction>{key_fn});
+}
+
+
+//kept for old callers, sorts with mystd::sort
+template<typename InputIterator, typename Cmp>
+void quickSort(InputIterator begin, InputIterator end, Cmp cmp) {
+    mystd::sort(begin, end, cmp);
+}
+
+template <typename InputIterator>
+void quickSort(InputIterator begin, InputIterator end) {
+    mystd::sort(begin, end);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,332 @@
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+
+/*
+* Memory resources and the allocators that draw from them.
+*
+* arena: monotonic buffer. Allocation bumps a pointer inside the current chunk,
+*	deallocation does nothing, and everything is freed at once by release() or
+*	when the arena is destroyed. Suited for per-request data.
+* pool: fixed-size blocks kept in free lists, one list per size class, so node
+*	based containers reuse freed nodes instead of calling malloc. Requests larger
+*	than MAX_BLOCK go straight to operator new.
+*
+* Neither resource is thread-safe, and each must outlive the containers using it.
+*
+* node_cache: the free list a single node based container (List, Queue, stack) keeps of
+*	its own erased nodes, so that steady insert/erase churn reuses memory without any
+*	resource being shared.
+*
+* mystd::arena a;
+* mystd::vector<int, mystd::arena_allocator<int>> v(a);
+*/
+namespace mystd {
+
+class arena {
+public:
+    using size_type = std::size_t;
+
+    explicit arena(size_type chunk_size = 4096) : next_chunk_size_(chunk_size) {}
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() {
+        release();
+    }
+
+    void* allocate(size_type bytes, size_type align = alignof(std::max_align_t)) {
+        void* p = cur_;
+        size_type space = end_ - cur_;
+        if (!std::align(align, bytes, p, space)) {
+            newChunk(bytes + align);
+            p = cur_;
+            space = end_ - cur_;
+            std::align(align, bytes, p, space);
+        }
+        cur_ = static_cast<char*>(p) + bytes;
+        return p;
+    }
+
+    //memory is only given back by release()
+    void deallocate(void*, size_type) noexcept {}
+
+    //free every chunk; all memory handed out by this arena becomes invalid
+    void release() noexcept {
+        while (chunks_) {
+            Chunk* next = chunks_->next;
+            ::operator delete(chunks_);
+            chunks_ = next;
+        }
+        cur_ = end_ = nullptr;
+    }
+
+private:
+    union Chunk {
+        Chunk* next;
+        std::max_align_t align_;
+    };
+
+    Chunk* chunks_ = nullptr;
+    char* cur_ = nullptr; //first free byte of current chunk
+    char* end_ = nullptr; //end of current chunk
+    size_type next_chunk_size_;
+
+    void newChunk(size_type min_size) {
+        size_type size = next_chunk_size_ < min_size ? min_size : next_chunk_size_;
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+        chunk->next = chunks_;
+        chunks_ = chunk;
+        cur_ = reinterpret_cast<char*>(chunk + 1);
+        end_ = cur_ + size;
+        next_chunk_size_ *= 2;
+    }
+};
+
+
+class pool {
+public:
+    using size_type = std::size_t;
+
+    static const size_type GRANULE = alignof(std::max_align_t);
+    static const size_type MAX_BLOCK = 16 * GRANULE;
+
+    explicit pool(size_type blocks_per_chunk = 64) : blocks_per_chunk_(blocks_per_chunk) {}
+
+    pool(const pool&) = delete;
+    pool& operator=(const pool&) = delete;
+
+    ~pool() {
+        release();
+    }
+
+    void* allocate(size_type bytes, size_type align = alignof(std::max_align_t)) {
+        if (bytes > MAX_BLOCK || align > GRANULE)
+            return ::operator new(bytes);
+        const size_type idx = sizeClass(bytes);
+        if (!free_[idx])
+            refill(idx);
+        Block* block = free_[idx];
+        free_[idx] = block->next;
+        return block;
+    }
+
+    void deallocate(void* p, size_type bytes, size_type align = alignof(std::max_align_t)) noexcept {
+        if (!p)
+            return;
+        if (bytes > MAX_BLOCK || align > GRANULE) {
+            ::operator delete(p);
+            return;
+        }
+        const size_type idx = sizeClass(bytes);
+        Block* block = static_cast<Block*>(p);
+        block->next = free_[idx];
+        free_[idx] = block;
+    }
+
+    //free every chunk, including blocks still in use
+    void release() noexcept {
+        while (chunks_) {
+            Chunk* next = chunks_->next;
+            ::operator delete(chunks_);
+            chunks_ = next;
+        }
+        for (Block*& list : free_)
+            list = nullptr;
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    union Chunk {
+        Chunk* next;
+        std::max_align_t align_;
+    };
+
+    static const size_type CLASS_CNT = MAX_BLOCK / GRANULE;
+
+    Block* free_[CLASS_CNT] = {};
+    Chunk* chunks_ = nullptr;
+    size_type blocks_per_chunk_;
+
+    //blocks of class idx are (idx + 1) * GRANULE bytes
+    static size_type sizeClass(size_type bytes) {
+        return bytes == 0 ? 0 : (bytes - 1) / GRANULE;
+    }
+
+    void refill(size_type idx) {
+        const size_type block_size = (idx + 1) * GRANULE;
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + block_size * blocks_per_chunk_));
+        chunk->next = chunks_;
+        chunks_ = chunk;
+        char* first = reinterpret_cast<char*>(chunk + 1);
+        for (size_type i = blocks_per_chunk_; i > 0; --i) {
+            Block* block = reinterpret_cast<Block*>(first + (i - 1) * block_size);
+            block->next = free_[idx];
+            free_[idx] = block;
+        }
+    }
+};
+
+
+template<typename T>
+class arena_allocator {
+public:
+    using value_type = T;
+
+    arena_allocator(arena& resource) noexcept : resource_(&resource) {}
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : resource_(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T));
+    }
+
+    arena* resource() const noexcept {
+        return resource_;
+    }
+
+private:
+    arena* resource_;
+};
+
+template<typename T, typename U>
+bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept {
+    return a.resource() == b.resource();
+}
+
+template<typename T, typename U>
+bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+
+template<typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+
+    pool_allocator(pool& resource) noexcept : resource_(&resource) {}
+
+    template<typename U>
+    pool_allocator(const pool_allocator<U>& other) noexcept : resource_(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    pool* resource() const noexcept {
+        return resource_;
+    }
+
+private:
+    pool* resource_;
+};
+
+template<typename T, typename U>
+bool operator==(const pool_allocator<T>& a, const pool_allocator<U>& b) noexcept {
+    return a.resource() == b.resource();
+}
+
+template<typename T, typename U>
+bool operator!=(const pool_allocator<T>& a, const pool_allocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+
+/*
+Memory of destroyed nodes, kept for the next node a container creates. Cached nodes are
+linked through their own storage. The cache holds at most max_cached() nodes, unlimited by
+default, so like a vector's capacity it only grows; release() hands it all back.
+*/
+template<typename NodeAllocator>
+class node_cache {
+public:
+    using size_type = std::size_t;
+
+private:
+    using node_traits = std::allocator_traits<NodeAllocator>;
+    using node_pointer = typename node_traits::pointer;
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    static_assert(sizeof(typename node_traits::value_type) >= sizeof(FreeNode), "node_cache needs nodes of at least a pointer");
+
+    FreeNode* free_ = nullptr;
+    size_type cached_ = 0;
+    size_type max_cached_ = static_cast<size_type>(-1);
+
+public:
+    node_cache() = default;
+
+    //the cache of one container never moves to another, whose allocator may differ
+    node_cache(const node_cache&) : node_cache() {}
+    node_cache& operator=(const node_cache&) { return *this; }
+
+    //release() must have been called with the container's allocator
+    ~node_cache() = default;
+
+    node_pointer allocate(NodeAllocator& alloc) {
+        if (!free_)
+            return node_traits::allocate(alloc, 1);
+        FreeNode* node = free_;
+        free_ = node->next;
+        --cached_;
+        return reinterpret_cast<node_pointer>(node);
+    }
+
+    //p must have been destroyed already
+    void deallocate(NodeAllocator& alloc, node_pointer p) noexcept {
+        if (cached_ >= max_cached_) {
+            node_traits::deallocate(alloc, p, 1);
+            return;
+        }
+        free_ = ::new (static_cast<void*>(p)) FreeNode{ free_ };
+        ++cached_;
+    }
+
+    void release(NodeAllocator& alloc) noexcept {
+        trim(alloc, 0);
+    }
+
+    size_type size() const noexcept {
+        return cached_;
+    }
+
+    size_type max_cached() const noexcept {
+        return max_cached_;
+    }
+
+    //nodes beyond the new limit are freed at once
+    void max_cached(NodeAllocator& alloc, size_type n) noexcept {
+        max_cached_ = n;
+        trim(alloc, n);
+    }
+
+private:
+    void trim(NodeAllocator& alloc, size_type n) noexcept {
+        while (cached_ > n) {
+            FreeNode* node = free_;
+            free_ = node->next;
+            --cached_;
+            node_traits::deallocate(alloc, reinterpret_cast<node_pointer>(node), 1);
+        }
+    }
+};
+
+}
@@ -0,0 +1,219 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <functional>
+#include "unordered_set.h"
+#include "hash_policy.h"
+
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#include <shared_mutex>
+#define MYSTD_SHARED_LOCKS
+#endif
+
+namespace mystd {
+
+//readers of a shard share its lock where the standard library offers one, C++14 and later
+#if defined(MYSTD_SHARED_LOCKS)
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+using shard_mutex = std::shared_mutex;
+#else
+using shard_mutex = std::shared_timed_mutex;
+#endif
+using shard_read_lock = std::shared_lock<shard_mutex>;
+#else
+using shard_mutex = std::mutex;
+using shard_read_lock = std::unique_lock<shard_mutex>;
+#endif
+
+/*
+A hash set for many threads: the key space is split across shards, each one an
+unordered_set with its own lock, so writers to different shards never wait for each other.
+
+Each shard sits in its own cache lines with its lock and its element count, and grows (or
+rehashes incrementally, see rehash_step) on its own while the other shards stay available.
+The shard of a key comes from the top bits of its hash times 2^64 / phi, while the shard
+itself indexes buckets with the low bits, so both spread well.
+
+There are no iterators, as they could not stay valid while other threads write; lookups
+return bool and for_each visits the elements shard by shard. size() adds up the shard
+counts without locking, so it is exact only when no thread is writing.
+*/
+template<typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>, typename Allocator = std::allocator<T>>
+class concurrent_unordered_set {
+public:
+    using key_type = T;
+    using value_type = T;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+
+private:
+    using set_type = unordered_set<T, Hash, Equal, Allocator>;
+
+    static const size_type CACHE_LINE_SIZE = 64;
+
+    //aligned and padded so that no two shards share a cache line
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        Shard(const hasher& hf, const key_equal& eql, const allocator_type& alloc) :set(0, hf, eql, alloc) {}
+
+        mutable shard_mutex lock;
+        std::atomic<size_type> size{ 0 };
+        set_type set;
+    };
+
+    hasher hash_;
+    void* raw_ = nullptr; //what operator new returned, shards_ is aligned inside it
+    Shard* shards_ = nullptr;
+    size_type shard_cnt_ = 0;
+
+    Shard& shardOf(const key_type& k) const {
+        const std::uint64_t mixed = static_cast<std::uint64_t>(hash_(k)) * 0x9E3779B97F4A7C15ull;
+        return shards_[mul_high(mixed, shard_cnt_)];
+    }
+
+    static size_type defaultShardCount() {
+        const size_type threads = std::thread::hardware_concurrency();
+        return threads == 0 ? 16 : 4 * threads;
+    }
+
+public:
+    /******constructor, destructor******/
+    explicit concurrent_unordered_set(size_type shard_count = defaultShardCount(), const hasher& hf = hasher(),
+        const key_equal& eql = key_equal(), const allocator_type& alloc = allocator_type()) :hash_(hf) {
+        shard_cnt_ = shard_count == 0 ? 1 : shard_count;
+        size_type space = shard_cnt_ * sizeof(Shard) + CACHE_LINE_SIZE;
+        raw_ = ::operator new(space);
+        void* p = raw_;
+        std::align(CACHE_LINE_SIZE, shard_cnt_ * sizeof(Shard), p, space);
+        shards_ = static_cast<Shard*>(p);
+        size_type built = 0;
+        try {
+            for (; built < shard_cnt_; ++built)
+                ::new (static_cast<void*>(shards_ + built)) Shard(hf, eql, alloc);
+        }
+        catch (...) {
+            while (built > 0)
+                shards_[--built].~Shard();
+            ::operator delete(raw_);
+            throw;
+        }
+    }
+
+    concurrent_unordered_set(const concurrent_unordered_set&) = delete;
+    concurrent_unordered_set& operator=(const concurrent_unordered_set&) = delete;
+
+    ~concurrent_unordered_set() {
+        for (size_type i = 0; i < shard_cnt_; ++i)
+            shards_[i].~Shard();
+        ::operator delete(raw_);
+    }
+
+    /******Capacity******/
+    //sum of the shard counts, each read without locking
+    size_type size() const noexcept {
+        size_type total = 0;
+        for (size_type i = 0; i < shard_cnt_; ++i)
+            total += shards_[i].size.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    size_type shard_count() const noexcept {
+        return shard_cnt_;
+    }
+
+    /******Element lookup******/
+    bool contains(const key_type& k) const {
+        const Shard& shard = shardOf(k);
+        shard_read_lock guard(shard.lock);
+        return shard.set.contains(k);
+    }
+
+    size_type count(const key_type& k) const {
+        return contains(k) ? 1 : 0;
+    }
+
+    //call f on every element; the shard being visited is locked for reading, so f must not modify *this
+    template<typename Function>
+    void for_each(Function f) const {
+        for (size_type i = 0; i < shard_cnt_; ++i) {
+            shard_read_lock guard(shards_[i].lock);
+            for (const value_type& val : shards_[i].set)
+                f(val);
+        }
+    }
+
+    /******Modifiers******/
+    bool insert(const value_type& val) {
+        Shard& shard = shardOf(val);
+        std::lock_guard<shard_mutex> guard(shard.lock);
+        const bool inserted = shard.set.insert(val).second;
+        shard.size.store(shard.set.size(), std::memory_order_relaxed);
+        return inserted;
+    }
+
+    bool insert(value_type&& val) {
+        Shard& shard = shardOf(val);
+        std::lock_guard<shard_mutex> guard(shard.lock);
+        const bool inserted = shard.set.insert(std::move(val)).second;
+        shard.size.store(shard.set.size(), std::memory_order_relaxed);
+        return inserted;
+    }
+
+    //the element is built before locking, as its hash picks the shard
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        value_type val(std::forward<Args>(args)...);
+        return insert(std::move(val));
+    }
+
+    size_type erase(const key_type& k) {
+        Shard& shard = shardOf(k);
+        std::lock_guard<shard_mutex> guard(shard.lock);
+        const size_type erased = shard.set.erase(k);
+        shard.size.store(shard.set.size(), std::memory_order_relaxed);
+        return erased;
+    }
+
+    //each shard is emptied under its own lock, not all at once
+    void clear() {
+        for (size_type i = 0; i < shard_cnt_; ++i) {
+            std::lock_guard<shard_mutex> guard(shards_[i].lock);
+            shards_[i].set.clear();
+            shards_[i].size.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /******Hash policy******/
+    //room for about n elements in all, split evenly across the shards
+    void reserve(size_type n) {
+        for (size_type i = 0; i < shard_cnt_; ++i) {
+            std::lock_guard<shard_mutex> guard(shards_[i].lock);
+            shards_[i].set.reserve(n / shard_cnt_ + 1);
+        }
+    }
+
+    //see unordered_set::rehash_step: bounds the time a writer holds a shard while it grows
+    void rehash_step(size_type n) {
+        for (size_type i = 0; i < shard_cnt_; ++i) {
+            std::lock_guard<shard_mutex> guard(shards_[i].lock);
+            shards_[i].set.rehash_step(n);
+        }
+    }
+
+    hasher hash_function() const {
+        return hash_;
+    }
+};
+
+}
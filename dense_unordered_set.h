@@ -0,0 +1,329 @@
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include "vector.h"
+#include "algorithm.h"
+#include "hash_policy.h"
+
+/*
+* dense_unordered_set: a chained hash set whose elements are stored contiguously.
+*
+* The elements sit back to back in one vector, in no particular order, and a parallel
+* vector keeps each element's hash and the index of the next element of its bucket. A
+* bucket holds only the index of its first element. Iteration is a scan of the element
+* vector, O(size()) whatever the bucket count, and iterators are plain pointers. Rehashing
+* relinks the chains from the stored hashes without calling the hasher or moving an element.
+*
+* Erase moves the last element into the hole, so it invalidates iterators and references
+* to the last element as well as to the erased one, and changes the iteration order.
+* Insertion may reallocate the element vector and invalidates every iterator when it does.
+* The rest of the interface follows mystd::unordered_set, without the bucket interface.
+*/
+namespace mystd {
+
+template<typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>, typename Allocator = std::allocator<T>,
+    typename BucketPolicy = prime_fastmod_policy>
+class dense_unordered_set {
+public:
+    using key_type = T;
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+    using bucket_policy = BucketPolicy;
+
+    //elements cannot be changed in place, as that would move them to another bucket
+    using const_iterator = const T*;
+    using iterator = const_iterator;
+
+private:
+    //what the chains are made of, one per element and at the same index
+    struct Link {
+        size_type hash;
+        size_type next;
+    };
+
+    using link_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Link>;
+    using index_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_type>;
+
+    //end of a chain, and an empty bucket
+    static const size_type NIL = static_cast<size_type>(-1);
+
+    hasher hash_;
+    key_equal equal_;
+    bucket_policy policy_;
+    vector<T, Allocator> values_;
+    vector<Link, link_allocator> links_;
+    vector<size_type, index_allocator> buckets_; //index of the first element of each bucket
+    float max_load_factor_ = 1.0;
+
+private:
+    size_type findIndex(const key_type& k, size_type hash) const {
+        for (size_type i = buckets_[policy_.index(hash)]; i != NIL; i = links_[i].next) {
+            if (links_[i].hash == hash && equal_(values_[i], k))
+                return i;
+        }
+        return NIL;
+    }
+
+    //the slot that holds index i: its bucket head or the link of the element before it
+    size_type& linkTo(size_type i) {
+        size_type* link = &buckets_[policy_.index(links_[i].hash)];
+        while (*link != i)
+            link = &links_[*link].next;
+        return *link;
+    }
+
+    //spread the elements over bucket_cnt buckets, from their stored hashes
+    void relink(size_type bucket_cnt) {
+        buckets_.assign(bucket_cnt, size_type(NIL));
+        policy_.set_bucket_count(bucket_cnt);
+        for (size_type i = 0; i < links_.size(); ++i) {
+            size_type& head = buckets_[policy_.index(links_[i].hash)];
+            links_[i].next = head;
+            head = i;
+        }
+    }
+
+    //make room for one more element
+    void prepareInsert() {
+        const size_type n = size() + 1;
+        if (static_cast<float>(n) > max_load_factor_ * static_cast<float>(bucket_count()))
+            relink(policy_.bucket_count_for(mystd::max(2 * bucket_count(), bucketsFor(n))));
+    }
+
+    size_type bucketsFor(size_type n) const {
+        return static_cast<size_type>(static_cast<float>(n) / max_load_factor_) + 1;
+    }
+
+    //link the last element, whose hash is given, at the front of its bucket
+    void linkBack(size_type hash) {
+        size_type& head = buckets_[policy_.index(hash)];
+        links_.push_back(Link{ hash, head });
+        head = values_.size() - 1;
+    }
+
+    template<typename V>
+    std::pair<iterator, bool> insertValue(V&& val) {
+        const size_type hash = hash_(val);
+        const size_type idx = findIndex(val, hash);
+        if (idx != NIL)
+            return std::make_pair(begin() + idx, false);
+        prepareInsert();
+        values_.push_back(std::forward<V>(val));
+        try {
+            linkBack(hash);
+        }
+        catch (...) {
+            values_.pop_back();
+            throw;
+        }
+        return std::make_pair(end() - 1, true);
+    }
+
+    //remove the element at idx by moving the last element into it
+    void eraseIndex(size_type idx) {
+        linkTo(idx) = links_[idx].next;
+        const size_type last = size() - 1;
+        if (idx != last) {
+            linkTo(last) = idx;
+            values_[idx] = std::move(values_[last]);
+            links_[idx] = links_[last];
+        }
+        values_.pop_back();
+        links_.pop_back();
+    }
+
+public:
+    /******constructor, destructor and copy******/
+    //default and empty
+    dense_unordered_set() :dense_unordered_set(static_cast<size_type>(0)) {}
+
+    explicit dense_unordered_set(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& alloc = allocator_type()) :
+        hash_(hf), equal_(eql), values_(alloc), links_(link_allocator(alloc)), buckets_(index_allocator(alloc)) {
+        values_.reserve(n);
+        links_.reserve(n);
+        relink(policy_.bucket_count_for(n));
+    }
+
+    explicit dense_unordered_set(const allocator_type& alloc) :
+        dense_unordered_set(static_cast<size_type>(0), hasher(), key_equal(), alloc) {}
+
+    allocator_type get_allocator() const {
+        return values_.get_allocator();
+    }
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return values_.size();
+    }
+
+    bool empty() const noexcept {
+        return values_.empty();
+    }
+
+    /******Iterators******/
+    iterator begin() const noexcept {
+        return values_.begin();
+    }
+
+    iterator end() const noexcept {
+        return values_.end();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return values_.cbegin();
+    }
+
+    const_iterator cend() const noexcept {
+        return values_.cend();
+    }
+
+    /******Element lookup******/
+    const_iterator find(const key_type& k) const {
+        const size_type idx = findIndex(k, hash_(k));
+        return idx == NIL ? end() : begin() + idx;
+    }
+
+    size_type count(const key_type& k) const {
+        return findIndex(k, hash_(k)) == NIL ? 0 : 1;
+    }
+
+    bool contains(const key_type& k) const {
+        return count(k) != 0;
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type& k) const {
+        iterator ret = find(k);
+        return std::make_pair(ret, ret == end() ? ret : ret + 1);
+    }
+
+    /******Modifiers******/
+    std::pair<iterator, bool> insert(const value_type& val) {
+        return insertValue(val);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& val) {
+        return insertValue(std::move(val));
+    }
+
+    //the element is built at the back of the vector, and dropped again if it is already present
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        values_.emplace_back(std::forward<Args>(args)...);
+        const size_type hash = hash_(values_.back());
+        const size_type idx = findIndex(values_.back(), hash);
+        if (idx != NIL) {
+            values_.pop_back();
+            return std::make_pair(begin() + idx, false);
+        }
+        try {
+            prepareInsert();
+            linkBack(hash);
+        }
+        catch (...) {
+            values_.pop_back();
+            throw;
+        }
+        return std::make_pair(end() - 1, true);
+    }
+
+    //the element now at position, the former last one, or end()
+    iterator erase(const_iterator position) {
+        if (position < begin() || position >= end())
+            throw std::out_of_range("at mystd::dense_unordered_set::erase()");
+        const size_type idx = static_cast<size_type>(position - begin());
+        eraseIndex(idx);
+        return begin() + idx;
+    }
+
+    size_type erase(const key_type& k) {
+        const size_type idx = findIndex(k, hash_(k));
+        if (idx == NIL)
+            return 0;
+        eraseIndex(idx);
+        return 1;
+    }
+
+    //the bucket array is kept; the next insertions do not rehash
+    void clear() noexcept {
+        values_.clear();
+        links_.clear();
+        for (size_type i = 0; i < buckets_.size(); ++i)
+            buckets_[i] = NIL;
+    }
+
+    void swap(dense_unordered_set& other) {
+        using std::swap;
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        swap(policy_, other.policy_);
+        values_.swap(other.values_);
+        links_.swap(other.links_);
+        buckets_.swap(other.buckets_);
+        swap(max_load_factor_, other.max_load_factor_);
+    }
+
+    /******Buckets******/
+    size_type bucket_count() const noexcept {
+        return buckets_.size();
+    }
+
+    size_type max_bucket_count() const noexcept {
+        return policy_.max_bucket_count();
+    }
+
+    /******Hash policy******/
+    float load_factor() const noexcept {
+        return static_cast<float>(size()) / static_cast<float>(bucket_count());
+    }
+
+    float max_load_factor() const noexcept {
+        return max_load_factor_;
+    }
+
+    void max_load_factor(float ml) {
+        max_load_factor_ = ml;
+        rehash(0);
+    }
+
+    //at least n buckets, and enough for size() elements
+    void rehash(size_type n) {
+        const size_type bucket_cnt = policy_.bucket_count_for(mystd::max(n, bucketsFor(size())));
+        if (bucket_cnt != bucket_count())
+            relink(bucket_cnt);
+    }
+
+    void reserve(size_type n) {
+        values_.reserve(n);
+        links_.reserve(n);
+        if (bucketsFor(n) > bucket_count())
+            relink(policy_.bucket_count_for(bucketsFor(n)));
+    }
+
+    hasher hash_function() const {
+        return hash_;
+    }
+
+    key_equal key_eq() const {
+        return equal_;
+    }
+};
+
+template<typename T, typename Hash, typename Equal, typename Allocator, typename BucketPolicy>
+void swap(dense_unordered_set<T, Hash, Equal, Allocator, BucketPolicy>& lhs,
+    dense_unordered_set<T, Hash, Equal, Allocator, BucketPolicy>& rhs) {
+    lhs.swap(rhs);
+}
+
+}
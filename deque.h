@@ -1,94 +1,616 @@
-﻿#pragma once
-
-namespace mystd {
-
-template<typename T>
-class deque {
-private:
-	class Node {
-		friend class deque;
-	private:
-		T data;
-		Node* next;
-		Node* prev;
-	public:
-		Node() :next(nullptr), prev(nullptr) {}
-		Node(T _data) :Node(_data, nullptr, nullptr) {}
-		Node(T _data, Node* _next, Node* _prev) :data(_data), next(_next), prev(_prev) {}
-	};
-
-
-private:
-	Node* head;
-	Node* tail;
-	size_t dequeSize;
-
-public:
-	deque() :head(nullptr), tail(nullptr), dequeSize(0) {}
-	~deque() {
-		if (!empty()) {
-			while (head) {
-				Node* p = head;
-				head = head->next;
-				delete p;
-			}
-		}
-		head = tail = nullptr;
-		dequeSize = 0;
-	}
-	size_t size()const noexcept { return dequeSize; }
-	bool empty()const noexcept { return dequeSize == 0; }
-
-	void push_back(const T& value) {
-		if (empty()) {
-			head = tail = new Node(value);
-			dequeSize++;
-			return;
-		}
-		tail->next = new Node(value, nullptr, tail);
-		tail = tail->next;
-		dequeSize++;
-	}
-
-	void push_front(const T& value) {
-		if (empty()) {
-			head = tail = new Node(value);
-			dequeSize++;
-			return;
-		}
-		head->prev = new Node(value, head, nullptr);
-		head = head->next;
-		dequeSize++;
-	}
-
-	void pop_back() {
-		dequeSize--;
-		Node* p = tail;
-		tail = tail->prev;
-		if(tail)
-			tail->next = nullptr;
-		delete p;
-	}
-
-	void pop_front() {
-		dequeSize--;
-		Node* p = head;
-		head = head->next;
-		if(head)
-			head->prev = nullptr;
-		delete p;
-	}
-
-	T& front() {
-		if (!empty())
-			return head->data;
-		throw std::out_of_range("at mystd::deque::front()");
-	}
-
-	T& back() {
-		if (!empty())
-			return tail->data;
-		throw std::out_of_range("at mystd::deque::front()");
-	}
-};
-}
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include "iterator.h"
+
+/*
+* deque: a double-ended queue stored in fixed-size blocks.
+*
+* A central map holds pointers to the blocks, in order, and the elements fill the blocks
+* from start_ to finish_. Growing at either end fills the end block and then allocates one
+* more block, so elements never move, and the map itself is recentred or reallocated only
+* when it runs out of slots on that side. Random access is one division into the map.
+*
+* The block of finish_ always has room for one more element, so end() is a valid position
+* in an allocated block. Iterators are invalidated by any push or pop; references are
+* invalidated only by popping the element they refer to.
+*/
+namespace mystd {
+
+template<typename T, typename Allocator = std::allocator<T>>
+class deque {
+public:
+	using value_type = T;
+	using allocator_type = Allocator;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+private:
+	//elements per block: blocks of 4KB, and at least 16 elements for large types
+	static constexpr difference_type blockSize() {
+		return sizeof(T) < 256 ? static_cast<difference_type>(4096 / sizeof(T)) : 16;
+	}
+
+	using map_pointer = T**;
+
+public:
+	template<typename Ref, typename Ptr>
+	class Iterator {
+		friend class deque;
+		template<typename, typename> friend class Iterator;
+	public:
+		using value_type = T;
+		using pointer = Ptr;
+		using reference = Ref;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = mystd::random_access_iterator_tag;
+
+	public:
+		Iterator() :cur_(nullptr), first_(nullptr), last_(nullptr), node_(nullptr) {}
+		//iterator converts to const_iterator, not the other way
+		template<typename R, typename P, typename = typename std::enable_if<std::is_convertible<P, Ptr>::value>::type>
+		Iterator(const Iterator<R, P>& other) :cur_(other.cur_), first_(other.first_), last_(other.last_), node_(other.node_) {}
+
+		reference operator*() const {
+			return *cur_;
+		}
+
+		pointer operator->() const {
+			return cur_;
+		}
+
+		reference operator[](difference_type n) const {
+			return *(*this + n);
+		}
+
+		Iterator& operator++() {
+			if (++cur_ == last_) {
+				setNode(node_ + 1);
+				cur_ = first_;
+			}
+			return *this;
+		}
+
+		Iterator& operator--() {
+			if (cur_ == first_) {
+				setNode(node_ - 1);
+				cur_ = last_;
+			}
+			--cur_;
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator ret = *this;
+			++(*this);
+			return ret;
+		}
+
+		Iterator operator--(int) {
+			Iterator ret = *this;
+			--(*this);
+			return ret;
+		}
+
+		Iterator& operator+=(difference_type n) {
+			const difference_type offset = n + (cur_ - first_);
+			if (offset >= 0 && offset < blockSize()) {
+				cur_ += n;
+			}
+			else {
+				//floor division, the offset may be negative
+				const difference_type node_offset = offset > 0 ? offset / blockSize() : -((-offset - 1) / blockSize()) - 1;
+				setNode(node_ + node_offset);
+				cur_ = first_ + (offset - node_offset * blockSize());
+			}
+			return *this;
+		}
+
+		Iterator& operator-=(difference_type n) {
+			return *this += -n;
+		}
+
+		Iterator operator+(difference_type n) const {
+			Iterator ret = *this;
+			return ret += n;
+		}
+
+		friend Iterator operator+(difference_type n, const Iterator& it) {
+			return it + n;
+		}
+
+		Iterator operator-(difference_type n) const {
+			Iterator ret = *this;
+			return ret -= n;
+		}
+
+		template<typename R, typename P>
+		difference_type operator-(const Iterator<R, P>& other) const {
+			return blockSize() * (node_ - other.node_ - 1) + (cur_ - first_) + (other.last_ - other.cur_);
+		}
+
+		template<typename R, typename P>
+		bool operator==(const Iterator<R, P>& other) const {
+			return cur_ == other.cur_;
+		}
+
+		template<typename R, typename P>
+		bool operator!=(const Iterator<R, P>& other) const {
+			return cur_ != other.cur_;
+		}
+
+		template<typename R, typename P>
+		bool operator<(const Iterator<R, P>& other) const {
+			return node_ == other.node_ ? cur_ < other.cur_ : node_ < other.node_;
+		}
+
+		template<typename R, typename P>
+		bool operator>(const Iterator<R, P>& other) const {
+			return other < *this;
+		}
+
+		template<typename R, typename P>
+		bool operator<=(const Iterator<R, P>& other) const {
+			return !(other < *this);
+		}
+
+		template<typename R, typename P>
+		bool operator>=(const Iterator<R, P>& other) const {
+			return !(*this < other);
+		}
+
+	private:
+		void setNode(map_pointer node) {
+			node_ = node;
+			first_ = *node;
+			last_ = first_ + blockSize();
+		}
+
+		T* cur_;
+		T* first_; //the block of cur_
+		T* last_;
+		map_pointer node_; //the map slot of the block
+	};
+
+	using iterator = Iterator<T&, T*>;
+	using const_iterator = Iterator<const T&, const T*>;
+
+private:
+	using alloc_traits = std::allocator_traits<Allocator>;
+	using map_allocator = typename alloc_traits::template rebind_alloc<T*>;
+	using map_traits = std::allocator_traits<map_allocator>;
+
+	static const size_type INITIAL_MAP_SIZE = 8;
+
+	Allocator alloc_;
+	map_pointer map_ = nullptr;
+	size_type map_size_ = 0;
+	iterator start_;
+	iterator finish_;
+
+private:
+	T* allocateBlock() {
+		return alloc_traits::allocate(alloc_, blockSize());
+	}
+
+	void deallocateBlock(T* p) {
+		alloc_traits::deallocate(alloc_, p, blockSize());
+	}
+
+	map_pointer allocateMap(size_type n) {
+		map_allocator alloc(alloc_);
+		return map_traits::allocate(alloc, n);
+	}
+
+	void deallocateMap(map_pointer p, size_type n) {
+		map_allocator alloc(alloc_);
+		map_traits::deallocate(alloc, p, n);
+	}
+
+	//an empty map with one block in the middle, for an empty deque
+	void initMap() {
+		map_size_ = INITIAL_MAP_SIZE;
+		map_ = allocateMap(map_size_);
+		map_pointer node = map_ + map_size_ / 2;
+		try {
+			*node = allocateBlock();
+		}
+		catch (...) {
+			deallocateMap(map_, map_size_);
+			map_ = nullptr;
+			map_size_ = 0;
+			throw;
+		}
+		start_.setNode(node);
+		start_.cur_ = start_.first_;
+		finish_ = start_;
+	}
+
+	void destroyElem(iterator, iterator, std::true_type) {}
+
+	void destroyElem(iterator first, iterator last, std::false_type) {
+		for (; first != last; ++first)
+			alloc_traits::destroy(alloc_, first.cur_);
+	}
+
+	void destroyElem(iterator first, iterator last) {
+		destroyElem(first, last, std::is_trivially_destructible<T>());
+	}
+
+	//destroy every element and free every block and the map
+	void release() {
+		if (!map_)
+			return;
+		destroyElem(start_, finish_);
+		for (map_pointer node = start_.node_; node <= finish_.node_; ++node)
+			deallocateBlock(*node);
+		deallocateMap(map_, map_size_);
+		map_ = nullptr;
+		map_size_ = 0;
+	}
+
+	/*
+	Make room in the map for nodes_to_add more blocks on one side.
+	If the map is less than half full the blocks in use are recentred in place,
+	otherwise they move to a map at least twice as large.
+	*/
+	void reallocateMap(size_type nodes_to_add, bool add_at_front) {
+		const size_type old_nodes = finish_.node_ - start_.node_ + 1;
+		const size_type new_nodes = old_nodes + nodes_to_add;
+		map_pointer new_start;
+		if (map_size_ > 2 * new_nodes) {
+			new_start = map_ + (map_size_ - new_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
+			if (new_start < start_.node_) {
+				for (size_type i = 0; i < old_nodes; ++i)
+					new_start[i] = start_.node_[i];
+			}
+			else {
+				for (size_type i = old_nodes; i > 0; --i)
+					new_start[i - 1] = start_.node_[i - 1];
+			}
+		}
+		else {
+			const size_type new_map_size = map_size_ + (map_size_ > nodes_to_add ? map_size_ : nodes_to_add) + 2;
+			map_pointer new_map = allocateMap(new_map_size);
+			new_start = new_map + (new_map_size - new_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
+			for (size_type i = 0; i < old_nodes; ++i)
+				new_start[i] = start_.node_[i];
+			deallocateMap(map_, map_size_);
+			map_ = new_map;
+			map_size_ = new_map_size;
+		}
+		start_.setNode(new_start);
+		finish_.setNode(new_start + old_nodes - 1);
+	}
+
+	void reserveMapAtBack(size_type nodes_to_add) {
+		if (nodes_to_add + 1 > map_size_ - static_cast<size_type>(finish_.node_ - map_))
+			reallocateMap(nodes_to_add, false);
+	}
+
+	void reserveMapAtFront(size_type nodes_to_add) {
+		if (nodes_to_add > static_cast<size_type>(start_.node_ - map_))
+			reallocateMap(nodes_to_add, true);
+	}
+
+	//allocate the blocks for n more elements after finish_, keeping the room for end()
+	void reserveElemAtBack(size_type n) {
+		const size_type vacancies = finish_.last_ - finish_.cur_ - 1;
+		if (n <= vacancies)
+			return;
+		const size_type new_nodes = (n - vacancies + blockSize() - 1) / blockSize();
+		reserveMapAtBack(new_nodes);
+		size_type i = 1;
+		try {
+			for (; i <= new_nodes; ++i)
+				finish_.node_[i] = allocateBlock();
+		}
+		catch (...) {
+			for (size_type j = 1; j < i; ++j)
+				deallocateBlock(finish_.node_[j]);
+			throw;
+		}
+	}
+
+	//free the blocks after finish_, allocated by reserveElemAtBack but not used
+	void releaseAfterFinish(iterator reserved_end) {
+		for (map_pointer node = finish_.node_ + 1; node <= reserved_end.node_; ++node)
+			deallocateBlock(*node);
+	}
+
+	//the first push into a new block at the back
+	template<typename... Args>
+	void emplaceBackAux(Args&&... args) {
+		reserveMapAtBack(1);
+		finish_.node_[1] = allocateBlock();
+		try {
+			alloc_traits::construct(alloc_, finish_.cur_, std::forward<Args>(args)...);
+		}
+		catch (...) {
+			deallocateBlock(finish_.node_[1]);
+			throw;
+		}
+		finish_.setNode(finish_.node_ + 1);
+		finish_.cur_ = finish_.first_;
+	}
+
+	template<typename... Args>
+	void emplaceFrontAux(Args&&... args) {
+		reserveMapAtFront(1);
+		start_.node_[-1] = allocateBlock();
+		try {
+			alloc_traits::construct(alloc_, start_.node_[-1] + blockSize() - 1, std::forward<Args>(args)...);
+		}
+		catch (...) {
+			deallocateBlock(start_.node_[-1]);
+			throw;
+		}
+		start_.setNode(start_.node_ - 1);
+		start_.cur_ = start_.last_ - 1;
+	}
+
+	//forward iterators: the blocks are allocated once, and the elements are built into them
+	template<typename ForwardIterator>
+	void pushBackRange(ForwardIterator first, ForwardIterator last, std::true_type) {
+		const size_type n = static_cast<size_type>(mystd::distance(first, last));
+		reserveElemAtBack(n);
+		const iterator new_finish = finish_ + static_cast<difference_type>(n);
+		iterator cur = finish_;
+		try {
+			for (; first != last; ++first, ++cur)
+				alloc_traits::construct(alloc_, cur.cur_, *first);
+		}
+		catch (...) {
+			destroyElem(finish_, cur);
+			releaseAfterFinish(new_finish);
+			throw;
+		}
+		finish_ = new_finish;
+	}
+
+	template<typename InputIterator>
+	void pushBackRange(InputIterator first, InputIterator last, std::false_type) {
+		for (; first != last; ++first)
+			emplace_back(*first);
+	}
+
+public:
+	/******constructor, destructor and copy******/
+	deque() :deque(Allocator()) {}
+
+	explicit deque(const Allocator& alloc) :alloc_(alloc) {
+		initMap();
+	}
+
+	//the delegated constructor has finished, so the destructor cleans up if a copy throws
+	explicit deque(size_type n, const value_type& val = value_type(), const Allocator& alloc = Allocator()) :deque(alloc) {
+		for (size_type i = 0; i < n; ++i)
+			push_back(val);
+	}
+
+	deque(const deque& other) :deque(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+		push_back_range(other.begin(), other.end());
+	}
+
+	//other is left empty, with a map of its own
+	deque(deque&& other) :deque(other.alloc_) {
+		swap(other);
+	}
+
+	deque& operator=(const deque& other) {
+		if (this != &other) {
+			deque tmp(other);
+			swap(tmp);
+		}
+		return *this;
+	}
+
+	deque& operator=(deque&& other) {
+		if (this != &other) {
+			clear();
+			swap(other);
+		}
+		return *this;
+	}
+
+	~deque() {
+		release();
+	}
+
+	allocator_type get_allocator() const {
+		return alloc_;
+	}
+
+	/******Capacity******/
+	size_type size() const noexcept {
+		return finish_ - start_;
+	}
+
+	bool empty() const noexcept {
+		return finish_ == start_;
+	}
+
+	/******Element access******/
+	reference operator[](size_type index) {
+		return start_[static_cast<difference_type>(index)];
+	}
+
+	const_reference operator[](size_type index) const {
+		return start_[static_cast<difference_type>(index)];
+	}
+
+	reference at(size_type index) {
+		if (index >= size())
+			throw std::out_of_range("at mystd::deque::at()");
+		return (*this)[index];
+	}
+
+	const_reference at(size_type index) const {
+		if (index >= size())
+			throw std::out_of_range("at mystd::deque::at()");
+		return (*this)[index];
+	}
+
+	reference front() {
+		if (!empty())
+			return *start_;
+		throw std::out_of_range("at mystd::deque::front()");
+	}
+
+	const_reference front() const {
+		if (!empty())
+			return *start_;
+		throw std::out_of_range("at mystd::deque::front()");
+	}
+
+	reference back() {
+		if (!empty())
+			return *(finish_ - 1);
+		throw std::out_of_range("at mystd::deque::back()");
+	}
+
+	const_reference back() const {
+		if (!empty())
+			return *(finish_ - 1);
+		throw std::out_of_range("at mystd::deque::back()");
+	}
+
+	/******iterator******/
+	iterator begin() noexcept {
+		return start_;
+	}
+
+	const_iterator begin() const noexcept {
+		return start_;
+	}
+
+	const_iterator cbegin() const noexcept {
+		return start_;
+	}
+
+	iterator end() noexcept {
+		return finish_;
+	}
+
+	const_iterator end() const noexcept {
+		return finish_;
+	}
+
+	const_iterator cend() const noexcept {
+		return finish_;
+	}
+
+	/******Modifiers******/
+	template<typename... Args>
+	reference emplace_back(Args&&... args) {
+		if (finish_.cur_ != finish_.last_ - 1) {
+			alloc_traits::construct(alloc_, finish_.cur_, std::forward<Args>(args)...);
+			++finish_.cur_;
+		}
+		else {
+			emplaceBackAux(std::forward<Args>(args)...);
+		}
+		return back();
+	}
+
+	template<typename... Args>
+	reference emplace_front(Args&&... args) {
+		if (start_.cur_ != start_.first_) {
+			alloc_traits::construct(alloc_, start_.cur_ - 1, std::forward<Args>(args)...);
+			--start_.cur_;
+		}
+		else {
+			emplaceFrontAux(std::forward<Args>(args)...);
+		}
+		return front();
+	}
+
+	void push_back(const value_type& val) {
+		emplace_back(val);
+	}
+
+	void push_back(value_type&& val) {
+		emplace_back(std::move(val));
+	}
+
+	void push_front(const value_type& val) {
+		emplace_front(val);
+	}
+
+	void push_front(value_type&& val) {
+		emplace_front(std::move(val));
+	}
+
+	//append [first, last); with forward iterators the blocks are allocated up front
+	template<typename InputIterator>
+	void push_back_range(InputIterator first, InputIterator last) {
+		pushBackRange(first, last, is_forward_iterator<InputIterator>());
+	}
+
+	void pop_back() {
+		if (empty())
+			throw std::out_of_range("at mystd::deque::pop_back()");
+		if (finish_.cur_ == finish_.first_) {
+			deallocateBlock(finish_.first_);
+			finish_.setNode(finish_.node_ - 1);
+			finish_.cur_ = finish_.last_;
+		}
+		alloc_traits::destroy(alloc_, --finish_.cur_);
+	}
+
+	void pop_front() {
+		if (empty())
+			throw std::out_of_range("at mystd::deque::pop_front()");
+		alloc_traits::destroy(alloc_, start_.cur_);
+		if (start_.cur_ == start_.last_ - 1) {
+			deallocateBlock(start_.first_);
+			start_.setNode(start_.node_ + 1);
+			start_.cur_ = start_.first_;
+		}
+		else {
+			++start_.cur_;
+		}
+	}
+
+	//remove the first n elements, freeing the blocks they leave empty
+	void pop_front_n(size_type n) {
+		if (n > size())
+			throw std::out_of_range("at mystd::deque::pop_front_n()");
+		const iterator new_start = start_ + static_cast<difference_type>(n);
+		destroyElem(start_, new_start);
+		for (map_pointer node = start_.node_; node < new_start.node_; ++node)
+			deallocateBlock(*node);
+		start_ = new_start;
+	}
+
+	//the block of begin() is kept
+	void clear() noexcept {
+		destroyElem(start_, finish_);
+		for (map_pointer node = start_.node_ + 1; node <= finish_.node_; ++node)
+			deallocateBlock(*node);
+		finish_ = start_;
+	}
+
+	void swap(deque& other) {
+		using std::swap;
+		swap(alloc_, other.alloc_);
+		swap(map_, other.map_);
+		swap(map_size_, other.map_size_);
+		swap(start_, other.start_);
+		swap(finish_, other.finish_);
+	}
+};
+
+template<typename T, typename Allocator>
+void swap(deque<T, Allocator>& lhs, deque<T, Allocator>& rhs) {
+	lhs.swap(rhs);
+}
+
+}
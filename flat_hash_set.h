@@ -0,0 +1,633 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include "iterator.h"
+#include "simd.h"
+
+/*
+* flat_hash_set: open addressing hash set in the style of Swiss tables.
+*
+* Elements live inline in one flat array of slots. Alongside it a control array keeps one
+* byte per slot: EMPTY, DELETED, or the low 7 bits of the element's hash (H2) when the slot
+* is full. Slots are grouped 16 at a time; the rest of the hash (H1) picks the first group
+* and the probe moves over whole groups. A lookup loads the 16 control bytes of a group
+* into one SSE2 register, compares them all with H2 at once, and only touches the slots
+* whose byte matched, so it rarely calls key_equal more than once. It stops at the first
+* group that still has an EMPTY byte.
+*
+* The interface is the one of mystd::unordered_set, minus the bucket interface
+* (local iterators, bucket(), bucket_size()), which has no meaning without chains.
+* Unlike unordered_set, insertion may move elements and invalidates iterators and
+* references when the table grows.
+*/
+namespace mystd {
+
+template<typename T, typename Hash = std::hash <T>, typename Equal = std::equal_to<T>, typename Allocator = std::allocator<T>>
+class flat_hash_set {
+private:
+    using ctrl_t = signed char;
+    using ctrl_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using ctrl_traits = std::allocator_traits<ctrl_allocator>;
+
+    //a full slot holds its H2 in 0..127, every other state is negative
+    static const ctrl_t EMPTY = -128;
+    static const ctrl_t DELETED = -2;
+    static const ctrl_t SENTINEL = -1; //one past the last slot, stops iteration
+
+    static const std::size_t GROUP_WIDTH = 16;
+
+    //keys hashed and prefetched together by find_batch and contains_batch
+    static const std::size_t BATCH_SIZE = 16;
+
+    //the 16 control bytes of a group, compared all at once
+    class Group {
+    public:
+        explicit Group(const ctrl_t* ctrl) {
+#ifdef MYSTD_SIMD_X86
+            ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+            std::memcpy(ctrl_, ctrl, GROUP_WIDTH);
+#endif
+        }
+
+        //bit i is set when byte i equals h
+        unsigned match(ctrl_t h) const {
+#ifdef MYSTD_SIMD_X86
+            return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), ctrl_)));
+#else
+            unsigned mask = 0;
+            for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+                mask |= static_cast<unsigned>(ctrl_[i] == h) << i;
+            return mask;
+#endif
+        }
+
+        unsigned matchEmpty() const {
+            return match(EMPTY);
+        }
+
+        //EMPTY or DELETED: the sign bit is set
+        unsigned matchFree() const {
+#ifdef MYSTD_SIMD_X86
+            return static_cast<unsigned>(_mm_movemask_epi8(ctrl_));
+#else
+            unsigned mask = 0;
+            for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+                mask |= static_cast<unsigned>(ctrl_[i] < 0) << i;
+            return mask;
+#endif
+        }
+
+    private:
+#ifdef MYSTD_SIMD_X86
+        __m128i ctrl_;
+#else
+        ctrl_t ctrl_[GROUP_WIDTH];
+#endif
+    };
+
+public:
+    using key_type = T;
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+
+public:
+
+    class const_iterator {
+        friend class flat_hash_set;
+    public:
+        using value_type = T;
+        using pointer = const T*;
+        using reference = const T&;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = mystd::forward_iterator_tag;
+
+    public:
+        const_iterator() :ctrl_(nullptr), slot_(nullptr) {}
+
+        reference operator*() const {
+            return *slot_;
+        }
+
+        pointer operator->() const {
+            return slot_;
+        }
+
+        const_iterator& operator++() noexcept {
+            ++ctrl_;
+            ++slot_;
+            skipFree();
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator ret = *this;
+            ++(*this);
+            return ret;
+        }
+
+        bool operator==(const const_iterator& other) const noexcept {
+            return slot_ == other.slot_;
+        }
+
+        bool operator!=(const const_iterator& other) const noexcept {
+            return !(*this == other);
+        }
+
+    protected:
+        const_iterator(const ctrl_t* ctrl, const T* slot) :ctrl_(ctrl), slot_(slot) {}
+
+        //move to the next full slot, or to the sentinel
+        void skipFree() noexcept {
+            while (*ctrl_ < SENTINEL) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+    private:
+        const ctrl_t* ctrl_;
+        const T* slot_;
+    };
+
+    //key in flat_hash_set cannot be changed
+    using iterator = const_iterator;
+
+private:
+    hasher hash_;
+    key_equal equal_;
+    Allocator alloc_;
+    ctrl_t* ctrl_ = nullptr; //capacity_ control bytes followed by SENTINEL
+    pointer slots_ = nullptr;
+    size_type capacity_ = 0; //0 or a power of two, at least GROUP_WIDTH
+    size_type size_ = 0;
+    size_type growth_left_ = 0; //EMPTY slots that may still be filled before growing
+    float max_load_factor_ = 0.875f;
+
+    //spread the bits of the user hash: std::hash of an integer is often the integer itself
+    static std::uint64_t mix(size_type h) noexcept {
+        return static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ull;
+    }
+
+    //index of the first group to probe
+    static size_type h1(std::uint64_t mixed) noexcept {
+        return static_cast<size_type>(mixed ^ (mixed >> 32));
+    }
+
+    //the 7 bits kept in the control byte; the top bits of the product are the best mixed
+    static ctrl_t h2(std::uint64_t mixed) noexcept {
+        return static_cast<ctrl_t>(mixed >> 57);
+    }
+
+    size_type groupMask() const noexcept {
+        return capacity_ / GROUP_WIDTH - 1;
+    }
+
+    //EMPTY slots allowed by the load factor in a table of the given capacity:
+    //at least one, so that a tiny load factor still lets the table grow, and never all of them
+    size_type maxFill(size_type capacity) const noexcept {
+        if (capacity == 0)
+            return 0;
+        const size_type fill = static_cast<size_type>(static_cast<float>(capacity) * max_load_factor_);
+        return fill == 0 ? 1 : (fill < capacity ? fill : capacity - 1);
+    }
+
+    //capacity whose max fill holds n elements
+    size_type capacityFor(size_type n) const noexcept {
+        size_type capacity = GROUP_WIDTH;
+        while (maxFill(capacity) < n)
+            capacity *= 2;
+        return capacity;
+    }
+
+    //slot index of k, or capacity_ if absent
+    size_type findIndex(const key_type& k, std::uint64_t mixed) const {
+        if (capacity_ == 0)
+            return capacity_;
+        const ctrl_t tag = h2(mixed);
+        size_type group = h1(mixed) & groupMask();
+        for (size_type step = 1; step <= capacity_ / GROUP_WIDTH; ++step) {
+            const size_type base = group * GROUP_WIDTH;
+            const Group g(ctrl_ + base);
+            for (unsigned mask = g.match(tag); mask; mask &= mask - 1) {
+                const size_type idx = base + simd_ctz(mask);
+                if (equal_(slots_[idx], k))
+                    return idx;
+            }
+            if (g.matchEmpty())
+                break;
+            //triangular steps visit every group of a power-of-two table
+            group = (group + step) & groupMask();
+        }
+        return capacity_;
+    }
+
+    //first EMPTY or DELETED slot along the probe sequence of mixed
+    size_type findFreeIndex(std::uint64_t mixed) const noexcept {
+        size_type group = h1(mixed) & groupMask();
+        for (size_type step = 1;; ++step) {
+            const size_type base = group * GROUP_WIDTH;
+            const unsigned mask = Group(ctrl_ + base).matchFree();
+            if (mask)
+                return base + simd_ctz(mask);
+            group = (group + step) & groupMask();
+        }
+    }
+
+    void setCtrl(size_type idx, ctrl_t value) noexcept {
+        ctrl_[idx] = value;
+    }
+
+    //allocate an all-EMPTY table of the given capacity into *this, which must hold none
+    void allocateTable(size_type capacity) {
+        ctrl_allocator ctrl_alloc(alloc_);
+        ctrl_ = ctrl_traits::allocate(ctrl_alloc, capacity + 1);
+        try {
+            slots_ = alloc_traits::allocate(alloc_, capacity);
+        }
+        catch (...) {
+            ctrl_traits::deallocate(ctrl_alloc, ctrl_, capacity + 1);
+            ctrl_ = nullptr;
+            throw;
+        }
+        std::memset(ctrl_, static_cast<unsigned char>(EMPTY), capacity);
+        ctrl_[capacity] = SENTINEL;
+        capacity_ = capacity;
+        size_ = 0;
+        growth_left_ = maxFill(capacity);
+    }
+
+    void destroyElem() noexcept {
+        for (size_type i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0)
+                alloc_traits::destroy(alloc_, slots_ + i);
+        }
+    }
+
+    //destroy elements and free the table
+    void clearMem() noexcept {
+        if (!ctrl_)
+            return;
+        destroyElem();
+        ctrl_allocator ctrl_alloc(alloc_);
+        ctrl_traits::deallocate(ctrl_alloc, ctrl_, capacity_ + 1);
+        alloc_traits::deallocate(alloc_, slots_, capacity_);
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = size_ = growth_left_ = 0;
+    }
+
+    //place an element known to be absent; the table must have growth left
+    template<typename... Args>
+    size_type insertAbsent(std::uint64_t mixed, Args&&... args) {
+        const size_type idx = findFreeIndex(mixed);
+        alloc_traits::construct(alloc_, slots_ + idx, std::forward<Args>(args)...);
+        if (ctrl_[idx] == EMPTY && growth_left_ > 0)
+            --growth_left_;
+        setCtrl(idx, h2(mixed));
+        ++size_;
+        return idx;
+    }
+
+    //move every element into a fresh table of new_capacity; copy instead if the move may throw
+    void resize(size_type new_capacity) {
+        flat_hash_set bigger(hash_, equal_, alloc_);
+        bigger.max_load_factor_ = max_load_factor_;
+        bigger.allocateTable(new_capacity);
+        for (size_type i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0)
+                bigger.insertAbsent(mix(hash_(slots_[i])), std::move_if_noexcept(slots_[i]));
+        }
+        swap(bigger);
+    }
+
+    //make room for one more element
+    void prepareInsert() {
+        if (growth_left_ > 0)
+            return;
+        //mostly tombstones: rebuilding at the same size is enough
+        if (capacity_ > 0 && size_ * 2 <= maxFill(capacity_))
+            resize(capacity_);
+        else
+            resize(capacityFor(size_ + 1));
+    }
+
+    flat_hash_set(const hasher& hf, const key_equal& eql, const allocator_type& alloc) :
+        hash_(hf), equal_(eql), alloc_(alloc) {}
+
+    template<typename V>
+    std::pair<iterator, bool> insertUnique(V&& val) {
+        const std::uint64_t mixed = mix(hash_(val));
+        size_type idx = findIndex(val, mixed);
+        if (idx != capacity_)
+            return std::make_pair(iteratorAt(idx), false);
+        prepareInsert();
+        idx = insertAbsent(mixed, std::forward<V>(val));
+        return std::make_pair(iteratorAt(idx), true);
+    }
+
+    iterator iteratorAt(size_type idx) const noexcept {
+        return const_iterator(ctrl_ + idx, slots_ + idx);
+    }
+
+    /*
+    Look keys up BATCH_SIZE at a time: hash the whole group and prefetch the first control
+    group of each key, then prefetch the slot of the first tag match, then resolve the keys.
+    The cache misses of a group overlap instead of being paid one key after another.
+    */
+    template<typename ForwardIterator, typename OutputIterator, typename Emit>
+    OutputIterator lookupBatch(ForwardIterator first, ForwardIterator last, OutputIterator out, Emit emit) const {
+        std::uint64_t mixed[BATCH_SIZE];
+        while (first != last) {
+            size_type cnt = 0;
+            for (ForwardIterator iter = first; iter != last && cnt < BATCH_SIZE; ++iter, ++cnt) {
+                const key_type& k = *iter;
+                mixed[cnt] = mix(hash_(k));
+                if (capacity_ != 0)
+                    mystd::prefetch(ctrl_ + (h1(mixed[cnt]) & groupMask()) * GROUP_WIDTH);
+            }
+            for (size_type i = 0; i < cnt && capacity_ != 0; ++i) {
+                const size_type base = (h1(mixed[i]) & groupMask()) * GROUP_WIDTH;
+                const unsigned mask = Group(ctrl_ + base).match(h2(mixed[i]));
+                if (mask)
+                    mystd::prefetch(slots_ + base + simd_ctz(mask));
+            }
+            for (size_type i = 0; i < cnt; ++i, ++first) {
+                const key_type& k = *first;
+                *out++ = emit(findIndex(k, mixed[i]));
+            }
+        }
+        return out;
+    }
+
+public:
+    /******constructor, destructor and copy******/
+    //default and empty
+    flat_hash_set() :flat_hash_set(static_cast<size_type>(0)) {}
+
+    explicit flat_hash_set(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& alloc = allocator_type()) :
+        hash_(hf), equal_(eql), alloc_(alloc) {
+        if (n > 0)
+            allocateTable(capacityFor(n));
+    }
+
+    explicit flat_hash_set(const allocator_type& alloc) :
+        flat_hash_set(static_cast<size_type>(0), hasher(), key_equal(), alloc) {}
+
+    //copy: same hash and capacity, so every element keeps its slot
+    flat_hash_set(const flat_hash_set& other) :
+        hash_(other.hash_), equal_(other.equal_),
+        alloc_(alloc_traits::select_on_container_copy_construction(other.alloc_)),
+        max_load_factor_(other.max_load_factor_) {
+        if (other.capacity_ == 0)
+            return;
+        allocateTable(other.capacity_);
+        size_type i = 0;
+        try {
+            for (; i < capacity_; ++i) {
+                if (other.ctrl_[i] >= 0)
+                    alloc_traits::construct(alloc_, slots_ + i, other.slots_[i]);
+                ctrl_[i] = other.ctrl_[i];
+            }
+        }
+        catch (...) {
+            std::memset(ctrl_ + i, static_cast<unsigned char>(EMPTY), capacity_ - i);
+            clearMem();
+            throw;
+        }
+        size_ = other.size_;
+        growth_left_ = other.growth_left_;
+    }
+
+    //move
+    flat_hash_set(flat_hash_set&& other) noexcept :
+        hash_(other.hash_), equal_(other.equal_), alloc_(other.alloc_) {
+        swap(other);
+    }
+
+    flat_hash_set& operator=(const flat_hash_set& other) {
+        if (this == &other)
+            return *this;
+        flat_hash_set copy(other);
+        swap(copy);
+        return *this;
+    }
+
+    flat_hash_set& operator=(flat_hash_set&& other) noexcept {
+        if (this == &other)
+            return *this;
+        swap(other);
+        return *this;
+    }
+
+    ~flat_hash_set() {
+        clearMem();
+    }
+
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return size_;
+    }
+
+    size_type max_size()const noexcept {
+        return alloc_traits::max_size(alloc_);
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /******Iterators******/
+    iterator begin() const noexcept {
+        if (size_ == 0)
+            return end();
+        const_iterator it(ctrl_, slots_);
+        it.skipFree();
+        return it;
+    }
+
+    iterator end() const noexcept {
+        return const_iterator(ctrl_ + capacity_, slots_ + capacity_);
+    }
+
+    const_iterator cbegin()const noexcept {
+        return begin();
+    }
+
+    const_iterator cend()const noexcept {
+        return end();
+    }
+
+    /******Element lookup******/
+    const_iterator find(const key_type& k) const {
+        return iteratorAt(findIndex(k, mix(hash_(k))));
+    }
+
+    size_type count(const key_type& k) const {
+        return findIndex(k, mix(hash_(k))) != capacity_ ? 1 : 0;
+    }
+
+    bool contains(const key_type& k) const {
+        return count(k) != 0;
+    }
+
+    /*
+    find and contains for every key of [first, last), written to out in order; faster than a
+    loop of single lookups once the table is larger than the cache, see lookupBatch().
+    */
+    template<typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return lookupBatch(first, last, out, [this](size_type idx) { return iteratorAt(idx); });
+    }
+
+    template<typename ForwardIterator, typename OutputIterator>
+    OutputIterator contains_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        const size_type absent = capacity_;
+        return lookupBatch(first, last, out, [absent](size_type idx) { return idx != absent; });
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type& k) const {
+        iterator ret = this->find(k);
+        if (ret == end())
+            return std::make_pair(ret, ret);
+        iterator next = ret;
+        return std::make_pair(ret, ++next);
+    }
+
+    /******Modifiers******/
+    std::pair<iterator, bool> insert(const value_type& val) {
+        return insertUnique(val);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& val) {
+        return insertUnique(std::move(val));
+    }
+
+    iterator erase(const_iterator position) {
+        if (position == cend())
+            throw std::out_of_range("at mystd::flat_hash_set::erase()");
+
+        const size_type idx = position.slot_ - slots_;
+        alloc_traits::destroy(alloc_, slots_ + idx);
+        --size_;
+        //a group that still has an EMPTY byte never made a probe go past it
+        const size_type base = idx & ~(GROUP_WIDTH - 1);
+        if (Group(ctrl_ + base).matchEmpty()) {
+            setCtrl(idx, EMPTY);
+            ++growth_left_;
+        }
+        else {
+            setCtrl(idx, DELETED);
+        }
+        ++position;
+        return position;
+    }
+
+    size_type erase(const key_type& k) {
+        const size_type idx = findIndex(k, mix(hash_(k)));
+        if (idx == capacity_)
+            return 0;
+        erase(iteratorAt(idx));
+        return 1;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        const_iterator it = first;
+        while (it != last)
+            it = erase(it);
+        return last;
+    }
+
+    void swap(flat_hash_set& other) noexcept {
+        using std::swap;
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        swap(alloc_, other.alloc_);
+        swap(ctrl_, other.ctrl_);
+        swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_);
+        swap(size_, other.size_);
+        swap(growth_left_, other.growth_left_);
+        swap(max_load_factor_, other.max_load_factor_);
+    }
+
+    //destroy the elements but keep the table
+    void clear() noexcept {
+        if (!ctrl_)
+            return;
+        destroyElem();
+        std::memset(ctrl_, static_cast<unsigned char>(EMPTY), capacity_);
+        size_ = 0;
+        growth_left_ = maxFill(capacity_);
+    }
+
+    /******Buckets******/
+    //number of slots
+    size_type bucket_count()const noexcept {
+        return capacity_;
+    }
+
+    size_type max_bucket_count()const noexcept {
+        return max_size();
+    }
+
+    /******Hash policy******/
+    float load_factor()const noexcept {
+        return capacity_ == 0 ? 0.0f : static_cast<float>(size()) / static_cast<float>(capacity_);
+    }
+
+    float max_load_factor() const noexcept {
+        return max_load_factor_;
+    }
+
+    //probes need an EMPTY slot to stop, so z is kept within (0, 0.875]
+    void max_load_factor(float z) {
+        if (!(z > 0.0f))
+            throw std::out_of_range("at mystd::flat_hash_set::max_load_factor()");
+        max_load_factor_ = z < 0.875f ? z : 0.875f;
+        if (capacity_ > 0)
+            resize(capacityFor(size_));
+    }
+
+    //make room for at least n slots, and n elements at most max_load_factor() of them
+    void rehash(size_type n) {
+        size_type capacity = capacityFor(size_);
+        while (capacity < n)
+            capacity *= 2;
+        if (capacity != capacity_ || growth_left_ + size_ < maxFill(capacity_))
+            resize(capacity);
+    }
+
+    void reserve(size_type n) {
+        if (n > size_ + growth_left_)
+            resize(capacityFor(n));
+    }
+
+    hasher hash_function() const {
+        return hash_;
+    }
+
+    key_equal key_eq() const {
+        return equal_;
+    }
+};
+
+}
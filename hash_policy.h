@@ -0,0 +1,135 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+/*
+* Bucket index policies for mystd::unordered_set: how many buckets a table may have,
+* and how a hash value becomes a bucket index.
+*
+* prime_mod_policy: prime bucket counts, index = hash % count. A 64-bit division on
+*	every find, insert and erase.
+* prime_fastmod_policy (default): the same primes and the same spread, but the remainder
+*	comes from Lemire's fastmod, two multiplications by a constant precomputed whenever
+*	the bucket count changes. The hash is folded to 32 bits first.
+* power2_policy: power-of-two bucket counts. The hash is multiplied by 2^64 / phi and the
+*	top bits are kept (Fibonacci hashing), so identity hashes such as std::hash<int> on
+*	sequential or strided keys still spread over all buckets.
+*
+* A policy provides
+*	bucket_count_for(n):  the smallest supported bucket count not less than n
+*	set_bucket_count(n):  called with such a count before index() is used with it
+*	index(hash):          bucket of hash, below the count last set
+*	max_bucket_count()
+*/
+namespace mystd {
+
+//bucket counts of the prime policies
+inline const std::size_t* bucket_primes(std::size_t& cnt) {
+    static const std::size_t primes[] = {
+        53u, 97u, 193u, 389u, 769u, 1543u, 3079u, 6151u, 12289u, 24593u, 49157u,
+        98317u, 196613u, 393241u, 786433u, 1572869u, 3145739u, 6291469u, 12582917u,
+        25165843u, 50331653u, 100663319u, 201326611u, 402653189u, 805306457u,
+        1610612741u, 3221225473u, 4294967291u
+    };
+    cnt = sizeof(primes) / sizeof(primes[0]);
+    return primes;
+}
+
+//high 64 bits of the 128-bit product a * b
+inline std::uint64_t mul_high(std::uint64_t a, std::uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    //__extension__ keeps -pedantic quiet about the non-standard type
+    __extension__ typedef unsigned __int128 uint128_type;
+    return static_cast<std::uint64_t>((static_cast<uint128_type>(a) * b) >> 64);
+#else
+    const std::uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+    const std::uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+    const std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+    const std::uint64_t mid = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (mid >> 32);
+#endif
+}
+
+class prime_mod_policy {
+public:
+    using size_type = std::size_t;
+
+    size_type bucket_count_for(size_type n) const {
+        size_type cnt;
+        const size_type* primes = bucket_primes(cnt);
+        const size_type* prime_ptr = std::lower_bound(primes, primes + cnt, n);
+        return prime_ptr != primes + cnt ? *prime_ptr : primes[cnt - 1];
+    }
+
+    void set_bucket_count(size_type n) noexcept {
+        bucket_cnt_ = n;
+    }
+
+    size_type index(size_type hash) const noexcept {
+        return hash % bucket_cnt_;
+    }
+
+    size_type max_bucket_count() const noexcept {
+        size_type cnt;
+        return bucket_primes(cnt)[cnt - 1];
+    }
+
+private:
+    size_type bucket_cnt_ = 1;
+};
+
+class prime_fastmod_policy : public prime_mod_policy {
+public:
+    void set_bucket_count(size_type n) noexcept {
+        prime_mod_policy::set_bucket_count(n);
+        divisor_ = static_cast<std::uint64_t>(n);
+        multiplier_ = ~std::uint64_t(0) / divisor_ + 1;
+    }
+
+    //(hash mod 2^32) % n without dividing; exact for every divisor below 2^32
+    size_type index(size_type hash) const noexcept {
+        const std::uint64_t h = static_cast<std::uint64_t>(hash);
+        const std::uint32_t folded = static_cast<std::uint32_t>(h ^ (h >> 32));
+        const std::uint64_t fraction = multiplier_ * folded;
+        return static_cast<size_type>(mul_high(fraction, divisor_));
+    }
+
+private:
+    std::uint64_t divisor_ = 1;
+    std::uint64_t multiplier_ = 0; //ceil(2^64 / divisor_), wrapped to 0 for 1
+};
+
+class power2_policy {
+public:
+    using size_type = std::size_t;
+
+    static const size_type MIN_BUCKET_COUNT = 64;
+
+    size_type bucket_count_for(size_type n) const noexcept {
+        size_type cnt = MIN_BUCKET_COUNT;
+        while (cnt < n && cnt < max_bucket_count())
+            cnt *= 2;
+        return cnt;
+    }
+
+    void set_bucket_count(size_type n) noexcept {
+        shift_ = 64;
+        for (; n > 1; n >>= 1)
+            --shift_;
+    }
+
+    size_type index(size_type hash) const noexcept {
+        return static_cast<size_type>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    size_type max_bucket_count() const noexcept {
+        return (std::numeric_limits<size_type>::max() >> 1) + 1;
+    }
+
+private:
+    unsigned shift_ = 64 - 6; //64 minus log2 of the bucket count
+};
+
+}
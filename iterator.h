@@ -1,56 +1,92 @@
-﻿#pragma once
-
-namespace mystd {
-struct output_iterator_tag
-{
-};
-
-struct input_iterator_tag
-{
-};
-
-struct forward_iterator_tag : public input_iterator_tag
-{
-};
-
-struct bidirectional_iterator_tag : public forward_iterator_tag
-{
-};
-
-struct random_access_iterator_tag : public bidirectional_iterator_tag
-{
-};
-
-
-//萃取
-template <typename T>
-struct iterator_traits
-{
-    using iterator_category = typename T::iterator_category;
-    using value_type = typename T::value_type;
-    using difference_type = typename T::difference_type;
-    using pointer = typename T::pointer;
-    using reference = typename T::reference;
-};
-
-//for common pointer, vector::Iterator, for example
-template <typename T>
-struct iterator_traits<T*>
-{
-    using iterator_category = random_access_iterator_tag;
-    using value_type = T;
-    using difference_type = std::ptrdiff_t;
-    using pointer = T*;
-    using reference = T&;
-};
-
-template <typename T>
-struct iterator_traits<const T*>
-{
-    using iterator_category = random_access_iterator_tag;
-    using value_type = T;
-    using difference_type = std::ptrdiff_t;
-    using pointer = const T*;
-    using reference = const T&;
-};
+﻿#pragma once
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace mystd {
+struct output_iterator_tag
+{
+};
+
+struct input_iterator_tag
+{
+};
+
+struct forward_iterator_tag : public input_iterator_tag
+{
+};
+
+struct bidirectional_iterator_tag : public forward_iterator_tag
+{
+};
+
+struct random_access_iterator_tag : public bidirectional_iterator_tag
+{
+};
+
+
+//萃取
+template <typename T>
+struct iterator_traits
+{
+    using iterator_category = typename T::iterator_category;
+    using value_type = typename T::value_type;
+    using difference_type = typename T::difference_type;
+    using pointer = typename T::pointer;
+    using reference = typename T::reference;
+};
+
+//for common pointer, vector::Iterator, for example
+template <typename T>
+struct iterator_traits<T*>
+{
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+};
+
+template <typename T>
+struct iterator_traits<const T*>
+{
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+};
+
+
+//category checks accept both mystd and std iterator tags
+template <typename Iterator>
+struct is_forward_iterator : std::integral_constant<bool,
+    std::is_base_of<forward_iterator_tag, typename iterator_traits<Iterator>::iterator_category>::value ||
+    std::is_base_of<std::forward_iterator_tag, typename iterator_traits<Iterator>::iterator_category>::value> {};
+
+template <typename Iterator>
+struct is_random_access_iterator : std::integral_constant<bool,
+    std::is_base_of<random_access_iterator_tag, typename iterator_traits<Iterator>::iterator_category>::value ||
+    std::is_base_of<std::random_access_iterator_tag, typename iterator_traits<Iterator>::iterator_category>::value> {};
+
+template <typename Iterator>
+typename iterator_traits<Iterator>::difference_type
+distance(Iterator first, Iterator last, std::true_type) {
+    return last - first;
+}
+
+template <typename Iterator>
+typename iterator_traits<Iterator>::difference_type
+distance(Iterator first, Iterator last, std::false_type) {
+    typename iterator_traits<Iterator>::difference_type n = 0;
+    for (; first != last; ++first)
+        ++n;
+    return n;
+}
+
+template <typename Iterator>
+typename iterator_traits<Iterator>::difference_type distance(Iterator first, Iterator last) {
+    return mystd::distance(first, last,
+        std::integral_constant<bool, is_random_access_iterator<Iterator>::value>());
+}
 }
\ No newline at end of file
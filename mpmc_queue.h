@@ -0,0 +1,274 @@
+﻿#pragma once
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+* mpmc_queue: a bounded queue for any number of producer and consumer threads, after
+* Dmitry Vyukov's array queue.
+*
+* Every cell of a power-of-two array carries a sequence number that says whose turn it is:
+* pos when the cell is free for the producer that claims position pos, pos + 1 once that
+* producer has built its element there, and pos + capacity when the consumer of pos has
+* emptied it for the next round. A producer claims a position with one compare-exchange on
+* enqueue_pos_, a consumer with one on dequeue_pos_, and the cell's sequence number hands
+* the element over with a release store and an acquire load. Producers only contend with
+* producers and consumers with consumers.
+*
+* try_push and try_pop never wait. push and pop spin for a while, then sleep on a condition
+* variable; the sleeping side is counted, so a push or a pop takes the mutex only when a
+* thread on the other side is asleep.
+*
+* Elements are moved in and out of the cells, so T must be nothrow move constructible:
+* a claimed cell has to be filled.
+*/
+namespace mystd {
+
+template<typename T, typename Allocator = std::allocator<T>>
+class mpmc_queue {
+    static_assert(std::is_nothrow_move_constructible<T>::value, "mpmc_queue needs a nothrow move constructible T");
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+
+private:
+    struct Cell {
+        std::atomic<size_type> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* value() noexcept {
+            return reinterpret_cast<T*>(&storage);
+        }
+    };
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using cell_allocator = typename alloc_traits::template rebind_alloc<Cell>;
+    using cell_traits = std::allocator_traits<cell_allocator>;
+
+    static const size_type CACHE_LINE_SIZE = 64;
+    //failed attempts before a blocking push or pop goes to sleep
+    static const int SPIN_LIMIT = 64;
+
+    //fixed at construction, read by every thread
+    Allocator alloc_;
+    Cell* cells_ = nullptr;
+    size_type mask_ = 0; //capacity - 1
+
+    //producers hammer enqueue_pos_ and consumers dequeue_pos_, so each gets a 64-byte line of
+    //its own; padded by hand since a heap-allocated queue would not get alignas(64) before C++17
+    char padding0_[CACHE_LINE_SIZE];
+    std::atomic<size_type> enqueue_pos_{ 0 };
+    char padding1_[CACHE_LINE_SIZE];
+    std::atomic<size_type> dequeue_pos_{ 0 };
+    char padding2_[CACHE_LINE_SIZE];
+
+    //only for threads that sleep
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::atomic<size_type> full_waiters_{ 0 };
+    std::atomic<size_type> empty_waiters_{ 0 };
+
+private:
+    static size_type roundCapacity(size_type n) {
+        size_type cap = 2;
+        while (cap < n) {
+            if (cap > (static_cast<size_type>(-1) >> 1))
+                throw std::length_error("at mystd::mpmc_queue, capacity too large");
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    //claim a free cell, or return nullptr if the queue is full; pos is set to the claimed position
+    Cell* claimForPush(size_type& pos) noexcept {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell* cell = cells_ + (pos & mask_);
+            const size_type seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - pos);
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return cell;
+            }
+            else if (dif < 0) {
+                return nullptr;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //claim a full cell, or return nullptr if the queue is empty
+    Cell* claimForPop(size_type& pos) noexcept {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell* cell = cells_ + (pos & mask_);
+            const size_type seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return cell;
+            }
+            else if (dif < 0) {
+                return nullptr;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPushValue(T& val) noexcept {
+        size_type pos;
+        Cell* cell = claimForPush(pos);
+        if (!cell)
+            return false;
+        alloc_traits::construct(alloc_, cell->value(), std::move(val));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPopValue(T& val) {
+        size_type pos;
+        Cell* cell = claimForPop(pos);
+        if (!cell)
+            return false;
+        //the cell is freed before assigning to val, which may throw
+        T tmp(std::move(*cell->value()));
+        alloc_traits::destroy(alloc_, cell->value());
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        val = std::move(tmp);
+        return true;
+    }
+
+    /*
+    Wake a thread sleeping on cond, if any. The fence orders the cell just published before
+    the load of the waiter count; a waiter orders its count before its own retry the same way,
+    so either this thread sees the waiter or the waiter sees the cell.
+    */
+    void wake(std::condition_variable& cond, std::atomic<size_type>& waiters) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> guard(mutex_);
+            cond.notify_one();
+        }
+    }
+
+    //retry op, spinning and then sleeping on cond, until it succeeds
+    template<typename Operation>
+    void waitFor(Operation op, std::condition_variable& cond, std::atomic<size_type>& waiters) {
+        for (int i = 0; i < SPIN_LIMIT; ++i) {
+            if (op())
+                return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!op())
+            cond.wait(lock);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    /******constructor, destructor******/
+    //the capacity is rounded up to a power of two, at least 2
+    explicit mpmc_queue(size_type capacity, const Allocator& alloc = Allocator()) :alloc_(alloc) {
+        const size_type cap = roundCapacity(capacity);
+        cell_allocator cell_alloc(alloc_);
+        cells_ = cell_traits::allocate(cell_alloc, cap);
+        mask_ = cap - 1;
+        for (size_type i = 0; i < cap; ++i)
+            ::new (static_cast<void*>(&cells_[i].sequence)) std::atomic<size_type>(i);
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    //no thread may be using the queue any more
+    ~mpmc_queue() {
+        const size_type end = enqueue_pos_.load(std::memory_order_acquire);
+        for (size_type pos = dequeue_pos_.load(std::memory_order_acquire); pos != end; ++pos)
+            alloc_traits::destroy(alloc_, cells_[pos & mask_].value());
+        cell_allocator cell_alloc(alloc_);
+        cell_traits::deallocate(cell_alloc, cells_, mask_ + 1);
+    }
+
+    /******Capacity******/
+    size_type capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    //exact only when no thread is pushing or popping
+    size_type size() const noexcept {
+        const size_type head = dequeue_pos_.load(std::memory_order_acquire);
+        const size_type tail = enqueue_pos_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /******Non-blocking******/
+    //false when the queue is full; the element is built before a cell is claimed
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        T val(std::forward<Args>(args)...);
+        if (!tryPushValue(val))
+            return false;
+        wake(not_empty_, empty_waiters_);
+        return true;
+    }
+
+    bool try_push(const value_type& val) {
+        return try_emplace(val);
+    }
+
+    bool try_push(value_type&& val) {
+        return try_emplace(std::move(val));
+    }
+
+    //false, and val is untouched, when the queue is empty
+    bool try_pop(value_type& val) {
+        if (!tryPopValue(val))
+            return false;
+        wake(not_full_, full_waiters_);
+        return true;
+    }
+
+    /******Blocking******/
+    //wait while the queue is full
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        T val(std::forward<Args>(args)...);
+        waitFor([&] { return tryPushValue(val); }, not_full_, full_waiters_);
+        wake(not_empty_, empty_waiters_);
+    }
+
+    void push(const value_type& val) {
+        emplace(val);
+    }
+
+    void push(value_type&& val) {
+        emplace(std::move(val));
+    }
+
+    //wait while the queue is empty
+    void pop(value_type& val) {
+        waitFor([&] { return tryPopValue(val); }, not_empty_, empty_waiters_);
+        wake(not_full_, full_waiters_);
+    }
+};
+
+}
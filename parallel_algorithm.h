@@ -0,0 +1,182 @@
+﻿#pragma once
+#include <functional>
+#include <utility>
+#include <thread>
+#include <exception>
+#include "iterator.h"
+#include "vector.h"
+#include "algorithm.h"
+
+/*
+* Multi-threaded algorithms built on the serial ones in algorithm.h.
+*
+* parallel_sort(first, last, comp, threads):
+*	the range is cut into one chunk per thread and every chunk is sorted with mystd::sort.
+*	The sorted runs are then merged pairwise, log2(threads) rounds in all. Every merge is cut
+*	into pieces of equal output size by a merge-path binary search, so each round keeps all
+*	threads busy, the last round included. Needs n extra elements of memory.
+*/
+namespace mystd {
+
+//ranges shorter than this are sorted by the calling thread alone
+const long PARALLEL_SORT_THRESHOLD = 1 << 15;
+//no thread gets fewer elements than this
+const long PARALLEL_SORT_MIN_CHUNK = 1 << 13;
+
+//run every task on its own thread and rethrow the first exception, if any, once all are joined
+inline void run_parallel(mystd::vector<std::function<void()>>& tasks) {
+    mystd::vector<std::exception_ptr> errors(tasks.size());
+    mystd::vector<std::thread> workers;
+    workers.reserve(tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        std::function<void()>* task = &tasks[i];
+        std::exception_ptr* error = &errors[i];
+        workers.emplace_back([task, error] {
+            try {
+                (*task)();
+            }
+            catch (...) {
+                *error = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    for (std::exception_ptr& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+//merge [first1, last1) and [first2, last2) into out by moving; equal elements keep the first range first
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator, typename Compare>
+OutputIterator move_merge(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, InputIterator2 last2,
+    OutputIterator out, Compare comp) {
+    while (first1 != last1 && first2 != last2) {
+        if (comp(*first2, *first1))
+            *out = std::move(*first2++);
+        else
+            *out = std::move(*first1++);
+        ++out;
+    }
+    for (; first1 != last1; ++first1, ++out)
+        *out = std::move(*first1);
+    for (; first2 != last2; ++first2, ++out)
+        *out = std::move(*first2);
+    return out;
+}
+
+/*
+Number of elements the merge of a[0, len_a) and b[0, len_b) takes from a
+among its first diag outputs (the merge path crossing diagonal diag).
+*/
+template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Distance, typename Compare>
+Distance merge_path(RandomAccessIterator1 a, Distance len_a, RandomAccessIterator2 b, Distance len_b,
+    Distance diag, Compare comp) {
+    Distance lo = diag > len_b ? diag - len_b : 0;
+    Distance hi = diag < len_a ? diag : len_a;
+    while (lo < hi) {
+        Distance mid = lo + (hi - lo) / 2;
+        //a[mid] is not greater than b[diag - mid - 1], so it comes before it in the merge
+        if (!comp(*(b + (diag - mid - 1)), *(a + mid)))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+//one round of merging adjacent runs of src, delimited by bounds, into dst
+template <typename SrcIterator, typename DstIterator, typename Compare>
+void parallel_merge_round(SrcIterator src, DstIterator dst, const mystd::vector<std::ptrdiff_t>& bounds,
+    std::size_t threads, Compare comp) {
+    const std::size_t runs = bounds.size() - 1;
+    const std::size_t pairs = (runs + 1) / 2;
+    const std::size_t parts = threads > pairs ? threads / pairs : 1;
+
+    mystd::vector<std::function<void()>> tasks;
+    for (std::size_t p = 0; p < pairs; ++p) {
+        const std::ptrdiff_t begin = bounds[2 * p];
+        const std::ptrdiff_t mid = bounds[2 * p + 1];
+        const std::ptrdiff_t end = 2 * p + 2 < bounds.size() ? bounds[2 * p + 2] : mid;
+        const std::ptrdiff_t len_a = mid - begin, len_b = end - mid;
+
+        //all cuts are found before any piece starts moving elements out of src
+        mystd::vector<std::ptrdiff_t> diags, cuts;
+        for (std::size_t part = 0; part <= parts; ++part) {
+            diags.push_back((len_a + len_b) * static_cast<std::ptrdiff_t>(part) / static_cast<std::ptrdiff_t>(parts));
+            cuts.push_back(mystd::merge_path(src + begin, len_a, src + mid, len_b, diags.back(), comp));
+        }
+        for (std::size_t part = 0; part < parts; ++part) {
+            const std::ptrdiff_t diag_lo = diags[part], diag_hi = diags[part + 1];
+            const std::ptrdiff_t a_lo = cuts[part], a_hi = cuts[part + 1];
+            tasks.emplace_back([=] {
+                mystd::move_merge(src + (begin + a_lo), src + (begin + a_hi),
+                    src + (mid + diag_lo - a_lo), src + (mid + diag_hi - a_hi),
+                    dst + (begin + diag_lo), comp);
+            });
+        }
+    }
+    mystd::run_parallel(tasks);
+}
+
+template <typename RandomAccessIterator, typename Compare>
+void parallel_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, std::size_t threads) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    const std::ptrdiff_t size = last - first;
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads > static_cast<std::size_t>(size / PARALLEL_SORT_MIN_CHUNK))
+        threads = size / PARALLEL_SORT_MIN_CHUNK;
+    if (threads < 2 || size < PARALLEL_SORT_THRESHOLD) {
+        mystd::sort(first, last, comp);
+        return;
+    }
+
+    //sort one chunk per thread
+    mystd::vector<std::ptrdiff_t> bounds;
+    for (std::size_t i = 0; i <= threads; ++i)
+        bounds.push_back(size * static_cast<std::ptrdiff_t>(i) / static_cast<std::ptrdiff_t>(threads));
+    mystd::vector<std::function<void()>> tasks;
+    for (std::size_t i = 0; i < threads; ++i) {
+        RandomAccessIterator chunk_first = first + bounds[i], chunk_last = first + bounds[i + 1];
+        tasks.emplace_back([=] { mystd::sort(chunk_first, chunk_last, comp); });
+    }
+    mystd::run_parallel(tasks);
+
+    //merge runs back and forth between the range and the buffer
+    mystd::vector<value_type> buffer;
+    buffer.reserve(size);
+    buffer.insert(buffer.end(), std::make_move_iterator(first), std::make_move_iterator(last));
+    bool in_buffer = true;
+    while (bounds.size() > 2) {
+        if (in_buffer)
+            mystd::parallel_merge_round(buffer.begin(), first, bounds, threads, comp);
+        else
+            mystd::parallel_merge_round(first, buffer.begin(), bounds, threads, comp);
+        in_buffer = !in_buffer;
+
+        mystd::vector<std::ptrdiff_t> merged;
+        for (std::size_t i = 0; i < bounds.size(); i += 2)
+            merged.push_back(bounds[i]);
+        if (merged.back() != size)
+            merged.push_back(size);
+        bounds.swap(merged);
+    }
+    if (in_buffer)
+        std::move(buffer.begin(), buffer.end(), first);
+}
+
+template <typename RandomAccessIterator, typename Compare>
+void parallel_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp) {
+    mystd::parallel_sort(first, last, comp, 0);
+}
+
+template <typename RandomAccessIterator>
+void parallel_sort(RandomAccessIterator first, RandomAccessIterator last) {
+    using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+    mystd::parallel_sort(first, last, std::less<value_type>(), 0);
+}
+
+}
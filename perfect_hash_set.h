@@ -0,0 +1,517 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "vector.h"
+#include "algorithm.h"
+#include "hash_policy.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MYSTD_HAS_MMAP
+#endif
+
+/*
+* perfect_hash_set: an immutable set of keys in one flat image, built once and loaded by
+* mapping the file, with no parsing and no copy. Processes that map the same file share
+* its pages.
+*
+* The table is a minimal perfect hash (hash and displace, as in PTHash): every key is
+* hashed once, the hash picks a bucket of about 4 keys, and the bucket's pilot, found at
+* build time, remaps the hashes of its keys to distinct positions in a table 1% larger than
+* the key count. The few keys that land past the last slot are sent to the slots left free
+* through a remap array, so the n keys fill slots [0, n) exactly; the spare 1% is what keeps
+* the pilot search of the last buckets short. A lookup reads one pilot, one slot offset and
+* the key bytes of that slot, and compares them with the key.
+*
+* Image layout, native byte order, every section aligned to 8 bytes:
+*	perfect_hash_header
+*	uint32 pilots[bucket_count]
+*	uint64 remap[table_size - key_count]	slot of a position past the last slot
+*	uint64 offsets[key_count + 1]	the key in slot s is keys[offsets[s], offsets[s + 1])
+*	char keys[]
+*
+* Keys are stored as bytes through perfect_hash_key<T>: the object representation of a
+* trivially copyable T (which must have no padding), or the characters of a std::string.
+*/
+namespace mystd {
+
+struct perfect_hash_header {
+    char magic[8];
+    std::uint32_t byte_order;   //BYTE_ORDER_MARK as written, to reject images from another byte order
+    std::uint32_t version;
+    std::uint64_t key_count;
+    std::uint64_t bucket_count;
+    std::uint64_t table_size;
+    std::uint64_t seed;
+    std::uint64_t pilots_offset;
+    std::uint64_t remap_offset;
+    std::uint64_t offsets_offset;
+    std::uint64_t keys_offset;
+    std::uint64_t image_size;
+
+    static const std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+    static const std::uint32_t VERSION = 1;
+};
+
+//the bytes a key is stored and compared as
+template<typename T, typename = void>
+struct perfect_hash_key;
+
+template<typename T>
+struct perfect_hash_key<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type> {
+    static const char* data(const T& k) noexcept {
+        return reinterpret_cast<const char*>(&k);
+    }
+
+    static std::size_t size(const T&) noexcept {
+        return sizeof(T);
+    }
+};
+
+template<typename CharT, typename Traits, typename Alloc>
+struct perfect_hash_key<std::basic_string<CharT, Traits, Alloc>> {
+    static const char* data(const std::basic_string<CharT, Traits, Alloc>& k) noexcept {
+        return reinterpret_cast<const char*>(k.data());
+    }
+
+    static std::size_t size(const std::basic_string<CharT, Traits, Alloc>& k) noexcept {
+        return k.size() * sizeof(CharT);
+    }
+};
+
+//64-bit MurmurHash2 of len bytes; stable across runs and processes, unlike std::hash
+inline std::uint64_t perfect_hash_bytes(const char* data, std::size_t len, std::uint64_t seed) noexcept {
+    const std::uint64_t m = 0xC6A4A7935BD1E995ull;
+    const int r = 47;
+    std::uint64_t h = seed ^ (static_cast<std::uint64_t>(len) * m);
+    for (; len >= 8; data += 8, len -= 8) {
+        std::uint64_t k;
+        std::memcpy(&k, data, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (len > 0) {
+        std::uint64_t tail = 0;
+        for (std::size_t i = len; i > 0; --i)
+            tail = (tail << 8) | static_cast<unsigned char>(data[i - 1]);
+        h ^= tail;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+template<typename T, typename KeyTraits = perfect_hash_key<T>>
+class perfect_hash_set {
+public:
+    using key_type = T;
+    using value_type = T;
+    using size_type = std::size_t;
+
+private:
+    //average keys per bucket: fewer buckets make a smaller image but a slower build
+    static const size_type KEYS_PER_BUCKET = 4;
+    //keys per 100 positions of the table the pilots map into
+    static const size_type LOAD_PERCENT = 99;
+    static const size_type ALIGNMENT = 8;
+
+    const unsigned char* image_ = nullptr;
+    size_type image_size_ = 0;
+    void* mapping_ = nullptr; //what munmap releases, if the image is a mapped file
+    vector<unsigned char> owned_; //the image, if it was read instead of mapped
+
+    const perfect_hash_header* header_ = nullptr;
+    const std::uint32_t* pilots_ = nullptr;
+    const std::uint64_t* remap_ = nullptr;
+    const std::uint64_t* offsets_ = nullptr;
+    const char* keys_ = nullptr;
+    size_type key_cnt_ = 0;
+    size_type bucket_cnt_ = 0;
+    size_type table_size_ = 0;
+    std::uint64_t seed_ = 0;
+
+private:
+    /*
+    60% of the keys go to the first 30% of the buckets (PTHash's skew). The crowded buckets are
+    placed first, while most positions are free, and the last buckets, placed when few are,
+    hold one or two keys.
+    */
+    static size_type bucketOf(std::uint64_t hash, size_type bucket_cnt) noexcept {
+        const size_type dense_cnt = bucket_cnt * 3 / 10 + 1;
+        const std::uint64_t spread = hash * 0x9E3779B97F4A7C15ull;
+        if (hash < 0x9999999999999999ull) //0.6 * 2^64
+            return static_cast<size_type>(mul_high(spread, dense_cnt));
+        return dense_cnt + static_cast<size_type>(mul_high(spread, bucket_cnt - dense_cnt));
+    }
+
+    //the pilot remixes the whole hash, so two keys of one bucket collide again only by chance
+    static size_type positionOf(std::uint64_t hash, std::uint32_t pilot, size_type table_size) noexcept {
+        std::uint64_t h = hash ^ (static_cast<std::uint64_t>(pilot) * 0x9E3779B97F4A7C15ull);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return static_cast<size_type>(mul_high(h, table_size));
+    }
+
+    static size_type alignUp(size_type n) noexcept {
+        return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    //check the header and locate the sections; the image itself is never copied or changed
+    void attach(const void* image, size_type bytes) {
+        image_ = static_cast<const unsigned char*>(image);
+        image_size_ = bytes;
+        if (bytes < sizeof(perfect_hash_header) || reinterpret_cast<std::uintptr_t>(image) % ALIGNMENT != 0)
+            throw std::runtime_error("perfect_hash_set: not a perfect hash image");
+        header_ = static_cast<const perfect_hash_header*>(image);
+        if (std::memcmp(header_->magic, "MYSTDPHS", 8) != 0 || header_->image_size != bytes)
+            throw std::runtime_error("perfect_hash_set: not a perfect hash image");
+        if (header_->byte_order != perfect_hash_header::BYTE_ORDER_MARK || header_->version != perfect_hash_header::VERSION)
+            throw std::runtime_error("perfect_hash_set: image of another byte order or version");
+        key_cnt_ = static_cast<size_type>(header_->key_count);
+        bucket_cnt_ = static_cast<size_type>(header_->bucket_count);
+        table_size_ = static_cast<size_type>(header_->table_size);
+        seed_ = header_->seed;
+        if (table_size_ < key_cnt_ ||
+            header_->pilots_offset + bucket_cnt_ * sizeof(std::uint32_t) > header_->remap_offset ||
+            header_->remap_offset + (table_size_ - key_cnt_) * sizeof(std::uint64_t) > header_->offsets_offset ||
+            header_->offsets_offset + (key_cnt_ + 1) * sizeof(std::uint64_t) > header_->keys_offset ||
+            header_->keys_offset > bytes)
+            throw std::runtime_error("perfect_hash_set: corrupt image");
+        pilots_ = reinterpret_cast<const std::uint32_t*>(image_ + header_->pilots_offset);
+        remap_ = reinterpret_cast<const std::uint64_t*>(image_ + header_->remap_offset);
+        offsets_ = reinterpret_cast<const std::uint64_t*>(image_ + header_->offsets_offset);
+        keys_ = reinterpret_cast<const char*>(image_ + header_->keys_offset);
+        if (offsets_[key_cnt_] > bytes - header_->keys_offset)
+            throw std::runtime_error("perfect_hash_set: corrupt image");
+    }
+
+    void release() noexcept {
+#if defined(MYSTD_HAS_MMAP)
+        if (mapping_)
+            ::munmap(mapping_, image_size_);
+#endif
+        mapping_ = nullptr;
+        image_ = nullptr;
+        header_ = nullptr;
+        key_cnt_ = 0;
+    }
+
+    void swap(perfect_hash_set& other) noexcept {
+        std::swap(image_, other.image_);
+        std::swap(image_size_, other.image_size_);
+        std::swap(mapping_, other.mapping_);
+        owned_.swap(other.owned_);
+        std::swap(header_, other.header_);
+        std::swap(pilots_, other.pilots_);
+        std::swap(remap_, other.remap_);
+        std::swap(offsets_, other.offsets_);
+        std::swap(keys_, other.keys_);
+        std::swap(key_cnt_, other.key_cnt_);
+        std::swap(bucket_cnt_, other.bucket_cnt_);
+        std::swap(table_size_, other.table_size_);
+        std::swap(seed_, other.seed_);
+    }
+
+    /*
+    Place every key of a bucket at once, largest buckets first: try pilots 0, 1, 2, ... until
+    all the bucket's positions are free and distinct. Then move the keys placed past the last
+    slot to the free slots, recording where in remap. Returns false if two keys cannot be told
+    apart by their hashes, and build() retries with another seed.
+    */
+    static bool place(const vector<std::uint64_t>& hashes, size_type bucket_cnt, size_type table_size,
+        vector<std::uint32_t>& pilots, vector<std::uint64_t>& remap, vector<std::uint64_t>& slot_key) {
+        const size_type key_cnt = hashes.size();
+        //group the keys by bucket with a counting sort
+        vector<std::uint64_t> bucket_start(bucket_cnt + 1, 0);
+        for (size_type i = 0; i < key_cnt; ++i)
+            ++bucket_start[bucketOf(hashes[i], bucket_cnt) + 1];
+        for (size_type b = 0; b < bucket_cnt; ++b)
+            bucket_start[b + 1] += bucket_start[b];
+        vector<std::uint64_t> members(key_cnt, 0);
+        {
+            vector<std::uint64_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+            for (size_type i = 0; i < key_cnt; ++i)
+                members[fill[bucketOf(hashes[i], bucket_cnt)]++] = i;
+        }
+        vector<std::uint64_t> order(bucket_cnt, 0);
+        for (size_type b = 0; b < bucket_cnt; ++b)
+            order[b] = b;
+        mystd::sort(order.begin(), order.end(), [&](std::uint64_t a, std::uint64_t b) {
+            const std::uint64_t size_a = bucket_start[a + 1] - bucket_start[a];
+            const std::uint64_t size_b = bucket_start[b + 1] - bucket_start[b];
+            return size_a != size_b ? size_a > size_b : a < b;
+        });
+
+        slot_key.assign(table_size, 0);
+        //one bit per position: the late pilot searches probe it at random, it has to stay in cache
+        vector<std::uint64_t> taken(table_size / 64 + 1, 0);
+        pilots.assign(bucket_cnt, 0);
+        vector<std::uint64_t> positions;
+        for (size_type i = 0; i < bucket_cnt; ++i) {
+            const std::uint64_t b = order[i];
+            const size_type first = bucket_start[b], last = bucket_start[b + 1];
+            if (first == last)
+                break;
+            //equal hashes in one bucket collide for every pilot
+            for (size_type j = first + 1; j < last; ++j) {
+                for (size_type k = first; k < j; ++k) {
+                    if (hashes[members[j]] == hashes[members[k]])
+                        return false;
+                }
+            }
+            for (std::uint64_t pilot = 0;; ++pilot) {
+                if (pilot > 0xFFFFFFFFull)
+                    return false;
+                positions.clear();
+                bool ok = true;
+                for (size_type j = first; j < last && ok; ++j) {
+                    const std::uint64_t pos = positionOf(hashes[members[j]], static_cast<std::uint32_t>(pilot), table_size);
+                    ok = !(taken[pos / 64] >> (pos % 64) & 1);
+                    for (size_type k = 0; k < positions.size() && ok; ++k)
+                        ok = positions[k] != pos;
+                    positions.push_back(pos);
+                }
+                if (!ok)
+                    continue;
+                for (size_type j = first; j < last; ++j) {
+                    const std::uint64_t pos = positions[j - first];
+                    slot_key[pos] = members[j];
+                    taken[pos / 64] |= std::uint64_t(1) << (pos % 64);
+                }
+                pilots[b] = static_cast<std::uint32_t>(pilot);
+                break;
+            }
+        }
+
+        //as many slots are free below key_cnt as positions are taken above it
+        remap.assign(table_size - key_cnt, 0);
+        size_type free_slot = 0;
+        for (size_type pos = key_cnt; pos < table_size; ++pos) {
+            if (!(taken[pos / 64] >> (pos % 64) & 1))
+                continue;
+            while (taken[free_slot / 64] >> (free_slot % 64) & 1)
+                ++free_slot;
+            remap[pos - key_cnt] = free_slot;
+            slot_key[free_slot++] = slot_key[pos];
+        }
+        slot_key.erase(slot_key.begin() + key_cnt, slot_key.end());
+        return true;
+    }
+
+public:
+    /******build******/
+    //the image of the set of keys in [first, last); duplicates are stored once
+    template<typename InputIterator>
+    static vector<unsigned char> build(InputIterator first, InputIterator last) {
+        //the keys as bytes, duplicates included
+        vector<char> bytes;
+        vector<std::uint64_t> starts(1, 0);
+        for (; first != last; ++first) {
+            const T& k = *first;
+            const char* data = KeyTraits::data(k);
+            bytes.insert(bytes.end(), data, data + KeyTraits::size(k));
+            starts.push_back(bytes.size());
+        }
+        auto sameKey = [&](std::uint64_t a, std::uint64_t b) {
+            return starts[a + 1] - starts[a] == starts[b + 1] - starts[b] &&
+                std::memcmp(bytes.begin() + starts[a], bytes.begin() + starts[b], starts[a + 1] - starts[a]) == 0;
+        };
+
+        //(hash, key) sorted by hash: duplicates are adjacent, and so are distinct keys whose hashes collide
+        vector<std::pair<std::uint64_t, std::uint64_t>> by_hash(starts.size() - 1, std::pair<std::uint64_t, std::uint64_t>());
+        vector<std::uint64_t> unique_keys;
+        vector<std::uint64_t> hashes;
+        vector<std::uint32_t> pilots;
+        vector<std::uint64_t> remap;
+        vector<std::uint64_t> slot_key;
+        size_type key_cnt = 0, bucket_cnt = 0, table_size = 0;
+        std::uint64_t seed = 0x5EED;
+        for (;; ++seed) {
+            for (size_type i = 0; i < by_hash.size(); ++i)
+                by_hash[i] = std::make_pair(perfect_hash_bytes(bytes.begin() + starts[i], starts[i + 1] - starts[i], seed), i);
+            mystd::radix_sort_by_key(by_hash.begin(), by_hash.end(),
+                [](const std::pair<std::uint64_t, std::uint64_t>& entry) { return entry.first; });
+            unique_keys.clear();
+            hashes.clear();
+            bool collision = false;
+            for (size_type i = 0; i < by_hash.size() && !collision; ++i) {
+                if (i > 0 && by_hash[i].first == by_hash[i - 1].first) {
+                    collision = !sameKey(by_hash[i].second, by_hash[i - 1].second);
+                    continue;
+                }
+                unique_keys.push_back(by_hash[i].second);
+                hashes.push_back(by_hash[i].first);
+            }
+            if (collision)
+                continue;
+            key_cnt = unique_keys.size();
+            bucket_cnt = key_cnt / KEYS_PER_BUCKET + 2;
+            table_size = key_cnt * 100 / LOAD_PERCENT + 1;
+            if (place(hashes, bucket_cnt, table_size, pilots, remap, slot_key))
+                break;
+        }
+
+        //lay the image out
+        perfect_hash_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "MYSTDPHS", 8);
+        header.byte_order = perfect_hash_header::BYTE_ORDER_MARK;
+        header.version = perfect_hash_header::VERSION;
+        header.key_count = key_cnt;
+        header.bucket_count = bucket_cnt;
+        header.table_size = table_size;
+        header.seed = seed;
+        header.pilots_offset = alignUp(sizeof(perfect_hash_header));
+        header.remap_offset = alignUp(header.pilots_offset + bucket_cnt * sizeof(std::uint32_t));
+        header.offsets_offset = header.remap_offset + remap.size() * sizeof(std::uint64_t);
+        header.keys_offset = header.offsets_offset + (key_cnt + 1) * sizeof(std::uint64_t);
+        vector<std::uint64_t> offsets(1, 0);
+        for (size_type s = 0; s < key_cnt; ++s) {
+            const std::uint64_t k = unique_keys[slot_key[s]];
+            offsets.push_back(offsets.back() + (starts[k + 1] - starts[k]));
+        }
+        header.image_size = alignUp(header.keys_offset + offsets.back());
+
+        vector<unsigned char> image(header.image_size, 0);
+        std::memcpy(image.begin(), &header, sizeof(header));
+        std::memcpy(image.begin() + header.pilots_offset, pilots.begin(), bucket_cnt * sizeof(std::uint32_t));
+        std::memcpy(image.begin() + header.remap_offset, remap.begin(), remap.size() * sizeof(std::uint64_t));
+        std::memcpy(image.begin() + header.offsets_offset, offsets.begin(), offsets.size() * sizeof(std::uint64_t));
+        for (size_type s = 0; s < key_cnt; ++s) {
+            const std::uint64_t k = unique_keys[slot_key[s]];
+            std::memcpy(image.begin() + header.keys_offset + offsets[s], bytes.begin() + starts[k], starts[k + 1] - starts[k]);
+        }
+        return image;
+    }
+
+    template<typename InputIterator>
+    static void write(const std::string& path, InputIterator first, InputIterator last) {
+        const vector<unsigned char> image = build(first, last);
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(image.begin()), static_cast<std::streamsize>(image.size()));
+        if (!out)
+            throw std::runtime_error("perfect_hash_set: cannot write " + path);
+    }
+
+    //any container with begin() and end(), an unordered_set for instance
+    template<typename Container>
+    static void write(const std::string& path, const Container& keys) {
+        write(path, keys.begin(), keys.end());
+    }
+
+    /******load******/
+    perfect_hash_set() = default;
+
+    //a view of an image somewhere in memory, which must outlive the set
+    perfect_hash_set(const void* image, size_type bytes) {
+        attach(image, bytes);
+    }
+
+    //map the file read-only; where mmap is unavailable it is read into memory instead
+    static perfect_hash_set open(const std::string& path) {
+        perfect_hash_set set;
+#if defined(MYSTD_HAS_MMAP)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("perfect_hash_set: cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            throw std::runtime_error("perfect_hash_set: cannot read " + path);
+        }
+        void* p = ::mmap(nullptr, static_cast<size_type>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("perfect_hash_set: cannot map " + path);
+        set.mapping_ = p;
+        set.image_size_ = static_cast<size_type>(st.st_size);
+        set.attach(p, static_cast<size_type>(st.st_size));
+#else
+        std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+        if (!in)
+            throw std::runtime_error("perfect_hash_set: cannot open " + path);
+        const std::streamoff bytes = in.tellg();
+        in.seekg(0);
+        set.owned_.assign(static_cast<size_type>(bytes), 0);
+        if (!in.read(reinterpret_cast<char*>(set.owned_.begin()), bytes))
+            throw std::runtime_error("perfect_hash_set: cannot read " + path);
+        set.attach(set.owned_.begin(), set.owned_.size());
+#endif
+        return set;
+    }
+
+    perfect_hash_set(const perfect_hash_set&) = delete;
+    perfect_hash_set& operator=(const perfect_hash_set&) = delete;
+
+    perfect_hash_set(perfect_hash_set&& other) noexcept {
+        swap(other);
+    }
+
+    perfect_hash_set& operator=(perfect_hash_set&& other) noexcept {
+        perfect_hash_set moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    ~perfect_hash_set() {
+        release();
+    }
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return key_cnt_;
+    }
+
+    bool empty() const noexcept {
+        return key_cnt_ == 0;
+    }
+
+    //the image, to be written elsewhere or checked
+    const void* data() const noexcept {
+        return image_;
+    }
+
+    size_type image_size() const noexcept {
+        return image_size_;
+    }
+
+    /******Element lookup******/
+    //k given as the bytes perfect_hash_key would store it as
+    bool contains_bytes(const char* k, size_type len) const noexcept {
+        if (key_cnt_ == 0)
+            return false;
+        const std::uint64_t hash = perfect_hash_bytes(k, len, seed_);
+        size_type slot = positionOf(hash, pilots_[bucketOf(hash, bucket_cnt_)], table_size_);
+        if (slot >= key_cnt_)
+            slot = static_cast<size_type>(remap_[slot - key_cnt_]);
+        const std::uint64_t begin = offsets_[slot], end = offsets_[slot + 1];
+        return end - begin == len && std::memcmp(keys_ + begin, k, len) == 0;
+    }
+
+    bool contains(const key_type& k) const noexcept {
+        return contains_bytes(KeyTraits::data(k), KeyTraits::size(k));
+    }
+
+    size_type count(const key_type& k) const noexcept {
+        return contains(k) ? 1 : 0;
+    }
+};
+
+}
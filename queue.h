@@ -1,136 +1,196 @@
-﻿#pragma once
-#include "vector.h"
-#include "algorithm.h"
-
-namespace mystd {
-
-template<typename T>
-class Queue {
-private:
-	class Node {
-		friend class Queue;
-	private:
-		T data;
-		Node* next;
-	public:
-		Node() :next(nullptr) {}
-		Node(T _data) :Node(_data, nullptr) {}
-		Node(T _data, Node* _next) :data(_data), next(_next) {}
-	};
-
-
-private:
-	Node* head;
-	Node* tail;
-	size_t queueSize;
-
-public:
-	Queue() :head(nullptr), tail(nullptr), queueSize(0) {}
-	~Queue() {
-		while (head) {
-			Node* p = head;
-			head = head->next;
-			delete p;
-		}
-		head = tail = nullptr;
-		queueSize = 0;
-	}
-	size_t size()const noexcept { return queueSize; }
-	bool empty()const noexcept { return queueSize == 0; }
-
-	void push(const T& value) {
-		if (empty()) {
-			head = tail = new Node(value);
-			queueSize++;
-			return;
-		}
-		tail->next = new Node(value, nullptr);
-		tail = tail->next;
-		queueSize++;
-	}
-
-	void pop() {
-		queueSize--;
-		Node* p = head;
-		head = head->next;
-		delete p;
-	}
-
-	T& front() {
-		if (!empty())
-			return head->data;
-		throw std::out_of_range("at mystd::queue::front()");
-	}
-
-	T& back() {
-		if (!empty())
-			return tail->data;
-		throw std::out_of_range("at mystd::queue::back()");
-	}
-};
-
-
-template <typename T, typename Container = mystd::vector<T>, typename Compare = std::less<typename Container::value_type>> 
-class priority_queue {
-public:
-	using container_type = Container;
-	using value_type = typename Container::value_type;
-	using reference = typename Container::reference;
-	using const_reference = typename Container::const_reference;
-	using size_type = typename Container::size_type;
-
-private:
-	Compare comp_;
-	Container container_;
-
-public:
-	/* constructor */
-//TO DO: range and move-range
-	explicit priority_queue(const Compare& comp, const Container& ctnr)
-		: comp_(comp), container_(ctnr){
-		mystd::make_heap(container_.begin(), container_.end(), comp_);
-	}
-
-	explicit priority_queue(const Compare& comp = Compare(), Container&& ctnr = Container())
-		: comp_(comp), container_(std::move(ctnr)) {
-		mystd::make_heap(container_.begin(), container_.end(), comp_);
-	}
-
-	~priority_queue() = default;
-
-	bool empty() const{
-		return container_.empty();
-	}
-
-	size_type size() const{
-		return container_.size();
-	}
-
-	const_reference top() const{
-		if (empty()){
-			throw std::out_of_range("at priority_queue::top()");
-		}
-		return container_.front();
-	}
-
-	void pop(){
-		if (empty()) {
-			throw std::out_of_range("at priority_queue::top()");
-		}
-		mystd::pop_heap(container_.begin(), container_.end(), comp_);
-		container_.pop_back();
-	}
-
-	void push(const value_type& elem){
-		value_type copy = elem;
-		push(std::move(copy));
-	}
-
-	void push(value_type&& elem){
-		container_.push_back(elem);
-		mystd::push_heap(container_.begin(), container_.end(), comp_);
-	}
-};
-
-
-}
+﻿#pragma once
+#include <memory>
+#include "vector.h"
+#include "algorithm.h"
+#include "allocator.h"
+
+namespace mystd {
+
+template<typename T, typename Allocator = std::allocator<T>>
+class Queue {
+public:
+	using allocator_type = Allocator;
+
+private:
+	class Node {
+		friend class Queue;
+	private:
+		T data;
+		Node* next;
+	public:
+		Node() :next(nullptr) {}
+		Node(T _data) :Node(_data, nullptr) {}
+		Node(T _data, Node* _next) :data(_data), next(_next) {}
+	};
+
+
+private:
+	using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+	using node_traits = std::allocator_traits<node_allocator>;
+
+	template<typename... Args>
+	Node* createNode(Args&&... args) {
+		Node* p = cache_.allocate(alloc_);
+		try {
+			node_traits::construct(alloc_, p, std::forward<Args>(args)...);
+		}
+		catch (...) {
+			cache_.deallocate(alloc_, p);
+			throw;
+		}
+		return p;
+	}
+
+	//the memory is kept for the next createNode
+	void destroyNode(Node* p) {
+		node_traits::destroy(alloc_, p);
+		cache_.deallocate(alloc_, p);
+	}
+
+	Node* head;
+	Node* tail;
+	size_t queueSize;
+	node_allocator alloc_;
+	node_cache<node_allocator> cache_;
+
+public:
+	Queue() :Queue(Allocator()) {}
+	explicit Queue(const Allocator& alloc) :head(nullptr), tail(nullptr), queueSize(0), alloc_(alloc) {}
+	~Queue() {
+		while (head) {
+			Node* p = head;
+			head = head->next;
+			destroyNode(p);
+		}
+		head = tail = nullptr;
+		queueSize = 0;
+		cache_.release(alloc_);
+	}
+	size_t size()const noexcept { return queueSize; }
+	bool empty()const noexcept { return queueSize == 0; }
+
+	void push(const T& value) {
+		if (empty()) {
+			head = tail = createNode(value);
+			queueSize++;
+			return;
+		}
+		tail->next = createNode(value, nullptr);
+		tail = tail->next;
+		queueSize++;
+	}
+
+	void pop() {
+		queueSize--;
+		Node* p = head;
+		head = head->next;
+		destroyNode(p);
+	}
+
+	T& front() {
+		if (!empty())
+			return head->data;
+		throw std::out_of_range("at mystd::queue::front()");
+	}
+
+	T& back() {
+		if (!empty())
+			return tail->data;
+		throw std::out_of_range("at mystd::queue::back()");
+	}
+
+	/******Node cache******/
+	//erased nodes are kept for reuse, at most max_cached_nodes() of them; unlimited by default
+	size_t max_cached_nodes() const noexcept { return cache_.max_cached(); }
+	void max_cached_nodes(size_t n) { cache_.max_cached(alloc_, n); }
+	//free the cached nodes
+	void shrink_to_fit() { cache_.release(alloc_); }
+};
+
+
+/*
+Heap is the heap shape policy: binary_heap, or dary_heap<4> / dary_heap<8> whose shallower
+trees take fewer cache misses per pop once the queue outgrows the cache.
+*/
+template <typename T, typename Container = mystd::vector<T>, typename Compare = std::less<typename Container::value_type>,
+	typename Heap = binary_heap>
+class priority_queue {
+public:
+	using container_type = Container;
+	using value_type = typename Container::value_type;
+	using reference = typename Container::reference;
+	using const_reference = typename Container::const_reference;
+	using size_type = typename Container::size_type;
+
+private:
+	Compare comp_;
+	Container container_;
+
+public:
+	/* constructor */
+//TO DO: range and move-range
+	explicit priority_queue(const Compare& comp, const Container& ctnr)
+		: comp_(comp), container_(ctnr){
+		Heap::make(container_.begin(), container_.end(), comp_);
+	}
+
+	explicit priority_queue(const Compare& comp = Compare(), Container&& ctnr = Container())
+		: comp_(comp), container_(std::move(ctnr)) {
+		Heap::make(container_.begin(), container_.end(), comp_);
+	}
+
+	~priority_queue() = default;
+
+	bool empty() const{
+		return container_.empty();
+	}
+
+	size_type size() const{
+		return container_.size();
+	}
+
+	const_reference top() const{
+		if (empty()){
+			throw std::out_of_range("at priority_queue::top()");
+		}
+		return container_.front();
+	}
+
+	void pop(){
+		if (empty()) {
+			throw std::out_of_range("at priority_queue::pop()");
+		}
+		Heap::pop(container_.begin(), container_.end(), comp_);
+		container_.pop_back();
+	}
+
+	//remove the top element and return it by move
+	value_type pop_top(){
+		if (empty()) {
+			throw std::out_of_range("at priority_queue::pop_top()");
+		}
+		Heap::pop(container_.begin(), container_.end(), comp_);
+		value_type top = std::move(container_.back());
+		container_.pop_back();
+		return top;
+	}
+
+	void push(const value_type& elem){
+		value_type copy = elem;
+		push(std::move(copy));
+	}
+
+	void push(value_type&& elem){
+		container_.push_back(std::move(elem));
+		Heap::push(container_.begin(), container_.end(), comp_);
+	}
+
+	template<typename... Args>
+	void emplace(Args&&... args){
+		container_.emplace_back(std::forward<Args>(args)...);
+		Heap::push(container_.begin(), container_.end(), comp_);
+	}
+};
+
+
+}
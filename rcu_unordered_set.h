@@ -0,0 +1,516 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <functional>
+#include "vector.h"
+#include "hash_policy.h"
+
+/*
+* A hash set for tables that are read all the time and written rarely: readers take no
+* lock and write no memory that another thread writes or reads often.
+*
+* epoch_domain: epoch-based reclamation. A reader announces the epoch it started in, in a
+*	slot of its own cache line; memory unlinked by a writer is freed once every reader
+*	still inside started after the unlink.
+* rcu_unordered_set: buckets of singly linked nodes, like unordered_set, whose links are
+*	atomic. Writers are serialized by a mutex and publish new nodes, new links and new
+*	bucket arrays with release stores, so a reader sees the set before or after a write,
+*	never in between.
+*/
+namespace mystd {
+
+class epoch_domain {
+public:
+    using epoch_type = std::uint64_t;
+
+    static epoch_domain& instance() {
+        static epoch_domain domain;
+        return domain;
+    }
+
+    //readers may nest; only the outermost enter and leave touch the slot
+    void enter() noexcept {
+        Registration& reg = registration();
+        if (reg.depth++ == 0) {
+            reg.record->epoch.store(epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            //the slot is published before any shared pointer is read, see reclaimableBefore()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void leave() noexcept {
+        Registration& reg = registration();
+        if (--reg.depth == 0)
+            reg.record->epoch.store(QUIESCENT, std::memory_order_release);
+    }
+
+    //epoch to tag memory that has just been unlinked
+    epoch_type current() const noexcept {
+        return epoch_.load(std::memory_order_relaxed);
+    }
+
+    /*
+    Start a new epoch and return the oldest epoch a reader may still be in: memory retired
+    in an epoch before it is unreachable. Readers that enter from now on see the new epoch;
+    a reader that read the old one but has not published it yet is ordered by the fences to
+    see the unlinks that came before.
+    */
+    epoch_type reclaimableBefore() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        epoch_type oldest = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        for (Record* rec = records_.load(std::memory_order_acquire); rec; rec = rec->next) {
+            const epoch_type e = rec->epoch.load(std::memory_order_acquire);
+            if (e != QUIESCENT && e < oldest)
+                oldest = e;
+        }
+        return oldest;
+    }
+
+private:
+    static const epoch_type QUIESCENT = 0;
+    static const std::size_t CACHE_LINE_SIZE = 64;
+
+    /*
+    One per thread that has ever read, reused after the thread exits and never freed. The
+    padding keeps the epochs of two records out of one cache line, as operator new does not
+    align to one before C++17.
+    */
+    struct Record {
+        std::atomic<epoch_type> epoch{ QUIESCENT };
+        std::atomic<bool> in_use{ true };
+        Record* next = nullptr;
+        char padding_[CACHE_LINE_SIZE];
+    };
+
+    struct Registration {
+        explicit Registration(epoch_domain& domain) :record(domain.acquireRecord()) {}
+        ~Registration() {
+            record->in_use.store(false, std::memory_order_release);
+        }
+
+        Record* record;
+        std::size_t depth = 0;
+    };
+
+    std::atomic<epoch_type> epoch_{ 1 };
+    std::atomic<Record*> records_{ nullptr };
+
+    epoch_domain() = default;
+
+    Registration& registration() {
+        static thread_local Registration reg(*this);
+        return reg;
+    }
+
+    Record* acquireRecord() {
+        for (Record* rec = records_.load(std::memory_order_acquire); rec; rec = rec->next) {
+            bool expected = false;
+            if (!rec->in_use.load(std::memory_order_relaxed) &&
+                rec->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return rec;
+        }
+        Record* rec = new Record;
+        rec->next = records_.load(std::memory_order_relaxed);
+        while (!records_.compare_exchange_weak(rec->next, rec, std::memory_order_release, std::memory_order_relaxed)) {}
+        return rec;
+    }
+};
+
+//marks the calling thread as a reader of every rcu_unordered_set for its lifetime
+class epoch_guard {
+public:
+    epoch_guard() noexcept {
+        epoch_domain::instance().enter();
+    }
+
+    ~epoch_guard() {
+        epoch_domain::instance().leave();
+    }
+
+    epoch_guard(const epoch_guard&) = delete;
+    epoch_guard& operator=(const epoch_guard&) = delete;
+};
+
+/*
+Lookups are wait-free and scale with the number of reading cores; insert, erase and clear
+serialize on a mutex and are slower than unordered_set's. A bucket array is never resized
+in place: growth builds a new table with copies of the nodes, publishes it with one pointer
+store and retires the old one. assign() does the same for a whole new content, so a table
+that is rebuilt periodically appears to readers all at once.
+
+Pointers returned by find() stay valid while the calling thread holds an epoch_guard.
+*/
+template<typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>, typename Allocator = std::allocator<T>,
+    typename BucketPolicy = prime_fastmod_policy>
+class rcu_unordered_set {
+public:
+    using key_type = T;
+    using value_type = T;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+    using bucket_policy = BucketPolicy;
+
+private:
+    struct Node {
+        template<typename... Args>
+        explicit Node(size_type h, Args&&... args) :hash(h), value(std::forward<Args>(args)...) {}
+
+        std::atomic<Node*> next{ nullptr };
+        size_type hash;
+        T value;
+    };
+
+    //immutable once published, but for the links
+    struct Table {
+        bucket_policy policy;
+        size_type bucket_cnt;
+        std::atomic<Node*>* buckets;
+    };
+
+    struct Retired {
+        epoch_domain::epoch_type epoch;
+        Node* node;     //an unlinked node, or
+        Table* table;   //a replaced table with all its nodes
+    };
+
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using link_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::atomic<Node*>>;
+    using table_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Table>;
+    using retired_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Retired>;
+
+    //retired objects are reclaimed once this many wait
+    static const size_type RECLAIM_THRESHOLD = 64;
+
+    hasher hash_;
+    key_equal equal_;
+    node_allocator alloc_;
+    float max_load_factor_ = 1.0;
+    std::atomic<Table*> table_;
+    std::atomic<size_type> size_{ 0 };
+    std::mutex writer_lock_;
+    vector<Retired, retired_allocator> retired_; //guarded by writer_lock_
+
+private:
+    /******memory, writers only******/
+    template<typename... Args>
+    Node* newNode(size_type hash, Args&&... args) {
+        using traits = std::allocator_traits<node_allocator>;
+        Node* node = traits::allocate(alloc_, 1);
+        try {
+            traits::construct(alloc_, node, hash, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            traits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void freeNode(Node* node) noexcept {
+        using traits = std::allocator_traits<node_allocator>;
+        traits::destroy(alloc_, node);
+        traits::deallocate(alloc_, node, 1);
+    }
+
+    Table* newTable(size_type bucket_cnt) {
+        link_allocator link_alloc(alloc_);
+        table_allocator table_alloc(alloc_);
+        std::atomic<Node*>* buckets = std::allocator_traits<link_allocator>::allocate(link_alloc, bucket_cnt);
+        for (size_type i = 0; i < bucket_cnt; ++i)
+            ::new (static_cast<void*>(buckets + i)) std::atomic<Node*>(nullptr);
+        Table* table;
+        try {
+            table = std::allocator_traits<table_allocator>::allocate(table_alloc, 1);
+        }
+        catch (...) {
+            std::allocator_traits<link_allocator>::deallocate(link_alloc, buckets, bucket_cnt);
+            throw;
+        }
+        ::new (static_cast<void*>(table)) Table();
+        table->policy.set_bucket_count(bucket_cnt);
+        table->bucket_cnt = bucket_cnt;
+        table->buckets = buckets;
+        return table;
+    }
+
+    //free a table and the nodes still linked in it
+    void freeTable(Table* table) noexcept {
+        for (size_type i = 0; i < table->bucket_cnt; ++i) {
+            Node* node = table->buckets[i].load(std::memory_order_relaxed);
+            while (node) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                freeNode(node);
+                node = next;
+            }
+        }
+        link_allocator link_alloc(alloc_);
+        table_allocator table_alloc(alloc_);
+        std::allocator_traits<link_allocator>::deallocate(link_alloc, table->buckets, table->bucket_cnt);
+        table->~Table();
+        std::allocator_traits<table_allocator>::deallocate(table_alloc, table, 1);
+    }
+
+    void retire(Node* node, Table* table) {
+        retired_.push_back(Retired{ epoch_domain::instance().current(), node, table });
+        if (table || retired_.size() >= RECLAIM_THRESHOLD)
+            reclaim();
+    }
+
+    //free what no reader can reach any more
+    void reclaim() noexcept {
+        const epoch_domain::epoch_type oldest = epoch_domain::instance().reclaimableBefore();
+        size_type kept = 0;
+        for (size_type i = 0; i < retired_.size(); ++i) {
+            Retired& r = retired_[i];
+            if (r.epoch < oldest) {
+                if (r.node)
+                    freeNode(r.node);
+                else
+                    freeTable(r.table);
+            }
+            else {
+                retired_[kept++] = r;
+            }
+        }
+        retired_.erase(retired_.begin() + kept, retired_.end());
+    }
+
+    /******tables, writers only******/
+    Node* findNode(const Table* table, const key_type& k, size_type hash) const {
+        Node* node = table->buckets[table->policy.index(hash)].load(std::memory_order_acquire);
+        for (; node; node = node->next.load(std::memory_order_acquire)) {
+            if (node->hash == hash && equal_(node->value, k))
+                return node;
+        }
+        return nullptr;
+    }
+
+    //link node at the front of its bucket; readers see it whole or not at all
+    static void publish(Table* table, Node* node) noexcept {
+        std::atomic<Node*>& head = table->buckets[table->policy.index(node->hash)];
+        node->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        head.store(node, std::memory_order_release);
+    }
+
+    size_type bucketCountFor(size_type n) const {
+        return bucket_policy().bucket_count_for(static_cast<size_type>(static_cast<float>(n) / max_load_factor_) + 1);
+    }
+
+    //copy every element of table into a new one of bucket_cnt buckets
+    Table* copyTable(const Table* table, size_type bucket_cnt) {
+        Table* copy = newTable(bucket_cnt);
+        try {
+            for (size_type i = 0; i < table->bucket_cnt; ++i) {
+                for (Node* node = table->buckets[i].load(std::memory_order_relaxed); node;
+                    node = node->next.load(std::memory_order_relaxed))
+                    publish(copy, newNode(node->hash, node->value));
+            }
+        }
+        catch (...) {
+            freeTable(copy);
+            throw;
+        }
+        return copy;
+    }
+
+    void replaceTable(Table* table) {
+        Table* old = table_.exchange(table, std::memory_order_acq_rel);
+        retire(nullptr, old);
+    }
+
+    template<typename V>
+    bool insertValue(V&& val) {
+        std::lock_guard<std::mutex> guard(writer_lock_);
+        Table* table = table_.load(std::memory_order_relaxed);
+        const size_type hash = hash_(val);
+        if (findNode(table, val, hash))
+            return false;
+        const size_type n = size_.load(std::memory_order_relaxed) + 1;
+        if (static_cast<float>(n) > max_load_factor_ * static_cast<float>(table->bucket_cnt)) {
+            Table* grown = copyTable(table, bucketCountFor(2 * n));
+            replaceTable(grown);
+            table = grown;
+        }
+        publish(table, newNode(hash, std::forward<V>(val)));
+        size_.store(n, std::memory_order_relaxed);
+        return true;
+    }
+
+public:
+    /******constructor, destructor******/
+    explicit rcu_unordered_set(size_type n = 0, const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& alloc = allocator_type()) :
+        hash_(hf), equal_(eql), alloc_(alloc), table_(nullptr), retired_(retired_allocator(alloc)) {
+        table_.store(newTable(bucketCountFor(n)), std::memory_order_relaxed);
+    }
+
+    rcu_unordered_set(const rcu_unordered_set&) = delete;
+    rcu_unordered_set& operator=(const rcu_unordered_set&) = delete;
+
+    //no reader may still be inside
+    ~rcu_unordered_set() {
+        for (size_type i = 0; i < retired_.size(); ++i) {
+            if (retired_[i].node)
+                freeNode(retired_[i].node);
+            else
+                freeTable(retired_[i].table);
+        }
+        freeTable(table_.load(std::memory_order_relaxed));
+    }
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /******Element lookup, lock-free******/
+    //the element equal to k or nullptr; valid while the caller holds an epoch_guard
+    const_pointer find(const key_type& k) const {
+        const size_type hash = hash_(k);
+        const Table* table = table_.load(std::memory_order_acquire);
+        const Node* node = table->buckets[table->policy.index(hash)].load(std::memory_order_acquire);
+        for (; node; node = node->next.load(std::memory_order_acquire)) {
+            if (node->hash == hash && equal_(node->value, k))
+                return &node->value;
+        }
+        return nullptr;
+    }
+
+    bool contains(const key_type& k) const {
+        epoch_guard guard;
+        return find(k) != nullptr;
+    }
+
+    size_type count(const key_type& k) const {
+        return contains(k) ? 1 : 0;
+    }
+
+    //call f on the element equal to k, if any, while it cannot be freed
+    template<typename Function>
+    bool visit(const key_type& k, Function f) const {
+        epoch_guard guard;
+        const_pointer p = find(k);
+        if (p)
+            f(*p);
+        return p != nullptr;
+    }
+
+    //call f on every element of one version of the table
+    template<typename Function>
+    void for_each(Function f) const {
+        epoch_guard guard;
+        const Table* table = table_.load(std::memory_order_acquire);
+        for (size_type i = 0; i < table->bucket_cnt; ++i) {
+            for (const Node* node = table->buckets[i].load(std::memory_order_acquire); node;
+                node = node->next.load(std::memory_order_acquire))
+                f(node->value);
+        }
+    }
+
+    /******Modifiers, serialized******/
+    bool insert(const value_type& val) {
+        return insertValue(val);
+    }
+
+    bool insert(value_type&& val) {
+        return insertValue(std::move(val));
+    }
+
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        value_type val(std::forward<Args>(args)...);
+        return insertValue(std::move(val));
+    }
+
+    size_type erase(const key_type& k) {
+        std::lock_guard<std::mutex> guard(writer_lock_);
+        Table* table = table_.load(std::memory_order_relaxed);
+        const size_type hash = hash_(k);
+        std::atomic<Node*>* link = &table->buckets[table->policy.index(hash)];
+        for (Node* node = link->load(std::memory_order_relaxed); node; node = link->load(std::memory_order_relaxed)) {
+            if (node->hash == hash && equal_(node->value, k)) {
+                //readers standing on node still follow its next
+                link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+                size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                retire(node, nullptr);
+                return 1;
+            }
+            link = &node->next;
+        }
+        return 0;
+    }
+
+    //replace the whole content at once: readers see the old elements or the new ones
+    template<typename InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        vector<T, Allocator> values(alloc_);
+        values.insert(values.end(), first, last);
+        Table* table = newTable(bucketCountFor(values.size()));
+        size_type n = 0;
+        try {
+            for (size_type i = 0; i < values.size(); ++i) {
+                const size_type hash = hash_(values[i]);
+                if (!findNode(table, values[i], hash)) {
+                    publish(table, newNode(hash, std::move(values[i])));
+                    ++n;
+                }
+            }
+        }
+        catch (...) {
+            freeTable(table);
+            throw;
+        }
+        std::lock_guard<std::mutex> guard(writer_lock_);
+        replaceTable(table);
+        size_.store(n, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        Table* table = newTable(bucketCountFor(0));
+        std::lock_guard<std::mutex> guard(writer_lock_);
+        replaceTable(table);
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    /******Hash policy******/
+    void reserve(size_type n) {
+        std::lock_guard<std::mutex> guard(writer_lock_);
+        Table* table = table_.load(std::memory_order_relaxed);
+        const size_type bucket_cnt = bucketCountFor(n);
+        if (bucket_cnt > table->bucket_cnt)
+            replaceTable(copyTable(table, bucket_cnt));
+    }
+
+    size_type bucket_count() const noexcept {
+        return table_.load(std::memory_order_acquire)->bucket_cnt;
+    }
+
+    float max_load_factor() const noexcept {
+        return max_load_factor_;
+    }
+
+    hasher hash_function() const {
+        return hash_;
+    }
+
+    key_equal key_eq() const {
+        return equal_;
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_type(alloc_);
+    }
+};
+
+}
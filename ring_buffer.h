@@ -0,0 +1,551 @@
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include "iterator.h"
+
+/*
+* ring_buffer and static_ring_buffer: fixed-capacity circular buffers.
+*
+* The elements live in one array whose size is a power of two, from index head_ to tail_.
+* Both indices only ever count up, and the slot of an index is its low bits, so a full and
+* an empty buffer are told apart by tail_ - head_ and no slot is left unused.
+* Once the array exists, pushing and popping never allocate.
+*
+* push_back on a full buffer overwrites the oldest element, which suits sliding windows and
+* logs of recent events; try_push_back refuses instead. array_one() and array_two() give
+* the elements as the two contiguous runs they occupy, front to back, for bulk processing.
+*
+* ring_buffer allocates its array, static_ring_buffer keeps it inline; both share the
+* interface of ring_buffer_base.
+*/
+namespace mystd {
+
+template<typename T, typename Allocator>
+class ring_buffer_base {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template<typename Ref, typename Ptr>
+    class Iterator {
+        friend class ring_buffer_base;
+        template<typename, typename> friend class Iterator;
+    public:
+        using value_type = T;
+        using pointer = Ptr;
+        using reference = Ref;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = mystd::random_access_iterator_tag;
+
+    public:
+        Iterator() :elem_(nullptr), mask_(0), pos_(0) {}
+        //iterator converts to const_iterator, not the other way
+        template<typename R, typename P, typename = typename std::enable_if<std::is_convertible<P, Ptr>::value>::type>
+        Iterator(const Iterator<R, P>& other) :elem_(other.elem_), mask_(other.mask_), pos_(other.pos_) {}
+
+        reference operator*() const {
+            return elem_[pos_ & mask_];
+        }
+
+        pointer operator->() const {
+            return elem_ + (pos_ & mask_);
+        }
+
+        reference operator[](difference_type n) const {
+            return elem_[(pos_ + n) & mask_];
+        }
+
+        Iterator& operator++() {
+            ++pos_;
+            return *this;
+        }
+
+        Iterator& operator--() {
+            --pos_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator ret = *this;
+            ++pos_;
+            return ret;
+        }
+
+        Iterator operator--(int) {
+            Iterator ret = *this;
+            --pos_;
+            return ret;
+        }
+
+        Iterator& operator+=(difference_type n) {
+            pos_ += n;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n) {
+            pos_ -= n;
+            return *this;
+        }
+
+        Iterator operator+(difference_type n) const {
+            Iterator ret = *this;
+            return ret += n;
+        }
+
+        friend Iterator operator+(difference_type n, const Iterator& it) {
+            return it + n;
+        }
+
+        Iterator operator-(difference_type n) const {
+            Iterator ret = *this;
+            return ret -= n;
+        }
+
+        //positions are compared by their difference, which stays right when the indices wrap around
+        template<typename R, typename P>
+        difference_type operator-(const Iterator<R, P>& other) const {
+            return static_cast<difference_type>(pos_ - other.pos_);
+        }
+
+        template<typename R, typename P>
+        bool operator==(const Iterator<R, P>& other) const {
+            return pos_ == other.pos_;
+        }
+
+        template<typename R, typename P>
+        bool operator!=(const Iterator<R, P>& other) const {
+            return pos_ != other.pos_;
+        }
+
+        template<typename R, typename P>
+        bool operator<(const Iterator<R, P>& other) const {
+            return *this - other < 0;
+        }
+
+        template<typename R, typename P>
+        bool operator>(const Iterator<R, P>& other) const {
+            return other < *this;
+        }
+
+        template<typename R, typename P>
+        bool operator<=(const Iterator<R, P>& other) const {
+            return !(other < *this);
+        }
+
+        template<typename R, typename P>
+        bool operator>=(const Iterator<R, P>& other) const {
+            return !(*this < other);
+        }
+
+    private:
+        Iterator(T* elem, size_type mask, size_type pos) :elem_(elem), mask_(mask), pos_(pos) {}
+
+        T* elem_;
+        size_type mask_;
+        size_type pos_; //an index of the buffer, not yet reduced to a slot
+    };
+
+    using iterator = Iterator<T&, T*>;
+    using const_iterator = Iterator<const T&, const T*>;
+
+protected:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    Allocator alloc_;
+    pointer elem_ = nullptr;
+    size_type capacity_ = 0; //0 or a power of two
+    size_type head_ = 0; //index of the front element
+    size_type tail_ = 0; //index after the back element
+
+protected:
+    explicit ring_buffer_base(const Allocator& alloc) :alloc_(alloc) {}
+
+    ring_buffer_base(const ring_buffer_base&) = delete;
+    ring_buffer_base& operator=(const ring_buffer_base&) = delete;
+
+    ~ring_buffer_base() = default;
+
+    pointer slot(size_type index) const noexcept {
+        return elem_ + (index & (capacity_ - 1));
+    }
+
+    //append the elements of other, which must fit
+    template<typename OtherAllocator>
+    void appendFrom(const ring_buffer_base<T, OtherAllocator>& other) {
+        for (size_type i = 0; i < other.size(); ++i)
+            emplace_back(other[i]);
+    }
+
+    template<typename OtherAllocator>
+    void appendFrom(ring_buffer_base<T, OtherAllocator>&& other) {
+        for (size_type i = 0; i < other.size(); ++i)
+            emplace_back(std::move(other[i]));
+        other.clear();
+    }
+
+public:
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return tail_ - head_;
+    }
+
+    size_type capacity() const noexcept {
+        return capacity_;
+    }
+
+    bool empty() const noexcept {
+        return tail_ == head_;
+    }
+
+    bool full() const noexcept {
+        return size() == capacity_;
+    }
+
+    /******Element access******/
+    //index 0 is the front, the oldest element
+    reference operator[](size_type index) {
+        return *slot(head_ + index);
+    }
+
+    const_reference operator[](size_type index) const {
+        return *slot(head_ + index);
+    }
+
+    reference at(size_type index) {
+        if (index >= size())
+            throw std::out_of_range("at mystd::ring_buffer::at()");
+        return (*this)[index];
+    }
+
+    const_reference at(size_type index) const {
+        if (index >= size())
+            throw std::out_of_range("at mystd::ring_buffer::at()");
+        return (*this)[index];
+    }
+
+    reference front() {
+        if (empty())
+            throw std::out_of_range("at mystd::ring_buffer::front()");
+        return *slot(head_);
+    }
+
+    const_reference front() const {
+        if (empty())
+            throw std::out_of_range("at mystd::ring_buffer::front()");
+        return *slot(head_);
+    }
+
+    reference back() {
+        if (empty())
+            throw std::out_of_range("at mystd::ring_buffer::back()");
+        return *slot(tail_ - 1);
+    }
+
+    const_reference back() const {
+        if (empty())
+            throw std::out_of_range("at mystd::ring_buffer::back()");
+        return *slot(tail_ - 1);
+    }
+
+    //the first contiguous run of elements, from the front up to the end of the array
+    std::pair<pointer, size_type> array_one() noexcept {
+        if (empty())
+            return std::make_pair(elem_, size_type(0));
+        const size_type first = head_ & (capacity_ - 1);
+        const size_type n = capacity_ - first;
+        return std::make_pair(elem_ + first, n < size() ? n : size());
+    }
+
+    std::pair<const_pointer, size_type> array_one() const noexcept {
+        return const_cast<ring_buffer_base*>(this)->array_one();
+    }
+
+    //the rest, from the start of the array up to the back; empty if the elements do not wrap
+    std::pair<pointer, size_type> array_two() noexcept {
+        return std::make_pair(elem_, size() - array_one().second);
+    }
+
+    std::pair<const_pointer, size_type> array_two() const noexcept {
+        return const_cast<ring_buffer_base*>(this)->array_two();
+    }
+
+    /******iterator******/
+    iterator begin() noexcept {
+        return iterator(elem_, capacity_ - 1, head_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(elem_, capacity_ - 1, head_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(elem_, capacity_ - 1, tail_);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(elem_, capacity_ - 1, tail_);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    /******Modifiers******/
+    //when full, the front element is destroyed first and stays removed if the construction throws
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        if (full()) {
+            if (capacity_ == 0)
+                throw std::out_of_range("at mystd::ring_buffer::emplace_back(), no capacity");
+            alloc_traits::destroy(alloc_, slot(head_));
+            ++head_;
+        }
+        alloc_traits::construct(alloc_, slot(tail_), std::forward<Args>(args)...);
+        return *slot(tail_++);
+    }
+
+    //when full, overwrite the front element; if the assignment throws, nothing moves
+    void push_back(const value_type& val) {
+        if (full() && capacity_ != 0) {
+            *slot(head_) = val;
+            ++head_;
+            ++tail_;
+            return;
+        }
+        emplace_back(val);
+    }
+
+    void push_back(value_type&& val) {
+        if (full() && capacity_ != 0) {
+            *slot(head_) = std::move(val);
+            ++head_;
+            ++tail_;
+            return;
+        }
+        emplace_back(std::move(val));
+    }
+
+    //false, and nothing changes, when the buffer is full
+    bool try_push_back(const value_type& val) {
+        if (full())
+            return false;
+        emplace_back(val);
+        return true;
+    }
+
+    bool try_push_back(value_type&& val) {
+        if (full())
+            return false;
+        emplace_back(std::move(val));
+        return true;
+    }
+
+    void pop_front() {
+        if (empty())
+            throw std::out_of_range("at mystd::ring_buffer::pop_front()");
+        alloc_traits::destroy(alloc_, slot(head_++));
+    }
+
+    void pop_back() {
+        if (empty())
+            throw std::out_of_range("at mystd::ring_buffer::pop_back()");
+        alloc_traits::destroy(alloc_, slot(--tail_));
+    }
+
+    void clear() noexcept {
+        while (head_ != tail_)
+            alloc_traits::destroy(alloc_, slot(head_++));
+        head_ = tail_ = 0;
+    }
+};
+
+//a ring buffer over an allocated array; the capacity is rounded up to a power of two
+template<typename T, typename Allocator = std::allocator<T>>
+class ring_buffer : public ring_buffer_base<T, Allocator> {
+    using base = ring_buffer_base<T, Allocator>;
+    using typename base::alloc_traits;
+    using base::alloc_;
+    using base::elem_;
+    using base::capacity_;
+    using base::head_;
+    using base::tail_;
+
+public:
+    using typename base::size_type;
+    using typename base::allocator_type;
+
+private:
+    static size_type roundCapacity(size_type n) {
+        size_type cap = 1;
+        while (cap < n) {
+            if (cap > (static_cast<size_type>(-1) >> 1))
+                throw std::length_error("at mystd::ring_buffer, capacity too large");
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    void releaseStorage() {
+        this->clear();
+        if (elem_)
+            alloc_traits::deallocate(alloc_, elem_, capacity_);
+        elem_ = nullptr;
+        capacity_ = 0;
+    }
+
+    void stealFrom(ring_buffer& other) noexcept {
+        elem_ = other.elem_;
+        capacity_ = other.capacity_;
+        head_ = other.head_;
+        tail_ = other.tail_;
+        other.elem_ = nullptr;
+        other.capacity_ = other.head_ = other.tail_ = 0;
+    }
+
+public:
+    /******constructor, destructor and copy******/
+    //no capacity; set_capacity gives it one
+    ring_buffer() :ring_buffer(Allocator()) {}
+
+    explicit ring_buffer(const Allocator& alloc) :base(alloc) {}
+
+    explicit ring_buffer(size_type capacity, const Allocator& alloc = Allocator()) :base(alloc) {
+        set_capacity(capacity);
+    }
+
+    ring_buffer(const ring_buffer& other) :base(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+        set_capacity(other.capacity());
+        try {
+            this->appendFrom(other);
+        }
+        catch (...) {
+            releaseStorage();
+            throw;
+        }
+    }
+
+    //other is left with no capacity
+    ring_buffer(ring_buffer&& other) noexcept :base(other.alloc_) {
+        stealFrom(other);
+    }
+
+    ring_buffer& operator=(const ring_buffer& other) {
+        if (this != &other) {
+            ring_buffer tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    ring_buffer& operator=(ring_buffer&& other) {
+        if (this != &other) {
+            releaseStorage();
+            alloc_ = other.alloc_;
+            stealFrom(other);
+        }
+        return *this;
+    }
+
+    ~ring_buffer() {
+        releaseStorage();
+    }
+
+    /******Capacity******/
+    //move to an array of at least n slots, keeping the newest elements that fit
+    void set_capacity(size_type n) {
+        const size_type new_capacity = n == 0 ? 0 : roundCapacity(n);
+        if (new_capacity == capacity_)
+            return;
+        ring_buffer tmp(alloc_);
+        if (new_capacity != 0) {
+            tmp.elem_ = alloc_traits::allocate(alloc_, new_capacity);
+            tmp.capacity_ = new_capacity;
+        }
+        const size_type keep = this->size() < new_capacity ? this->size() : new_capacity;
+        for (size_type i = this->size() - keep; i < this->size(); ++i)
+            tmp.emplace_back(std::move_if_noexcept((*this)[i]));
+        swap(tmp);
+    }
+
+    /******Modifiers******/
+    void swap(ring_buffer& other) noexcept {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+        swap(elem_, other.elem_);
+        swap(capacity_, other.capacity_);
+        swap(head_, other.head_);
+        swap(tail_, other.tail_);
+    }
+};
+
+template<typename T, typename Allocator>
+void swap(ring_buffer<T, Allocator>& lhs, ring_buffer<T, Allocator>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+//a ring buffer of N slots kept inside the object; N must be a power of two
+template<typename T, std::size_t N>
+class static_ring_buffer : public ring_buffer_base<T, std::allocator<T>> {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "static_ring_buffer needs a power of two capacity");
+
+    using base = ring_buffer_base<T, std::allocator<T>>;
+    using base::elem_;
+    using base::capacity_;
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type inline_[N];
+
+public:
+    /******constructor, destructor and copy******/
+    static_ring_buffer() :base(std::allocator<T>()) {
+        elem_ = reinterpret_cast<T*>(inline_);
+        capacity_ = N;
+    }
+
+    static_ring_buffer(const static_ring_buffer& other) :static_ring_buffer() {
+        this->appendFrom(other);
+    }
+
+    //the elements are moved one by one, and other is left empty
+    static_ring_buffer(static_ring_buffer&& other) :static_ring_buffer() {
+        this->appendFrom(std::move(other));
+    }
+
+    static_ring_buffer& operator=(const static_ring_buffer& other) {
+        if (this != &other) {
+            this->clear();
+            this->appendFrom(other);
+        }
+        return *this;
+    }
+
+    static_ring_buffer& operator=(static_ring_buffer&& other) {
+        if (this != &other) {
+            this->clear();
+            this->appendFrom(std::move(other));
+        }
+        return *this;
+    }
+
+    ~static_ring_buffer() {
+        this->clear();
+    }
+};
+
+}
@@ -0,0 +1,292 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/*
+* SSE2/AVX2 kernels behind mystd::find, count, equal and mismatch.
+*
+* They run on contiguous arrays of integers, enums or pointers, where equality is
+* equality of the bits. AVX2 is picked at runtime with CPUID, SSE2 is always there on x86-64.
+* Other targets, or defining MYSTD_NO_SIMD, leave only the scalar loops.
+*
+* Every kernel compares whole vectors with cmpeq; matching lanes become all ones, so the
+* byte mask from movemask holds sizeof(T) set bits per equal element.
+*/
+#if !defined(MYSTD_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define MYSTD_SIMD_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MYSTD_TARGET_AVX2
+#else
+#define MYSTD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace mystd {
+
+//element types whose == is a bitwise comparison
+template <typename T>
+struct is_simd_comparable : std::integral_constant<bool,
+    (std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)> {};
+
+//ask for the cache line holding p ahead of its use; never faults, even on a bad address
+inline void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#elif defined(MYSTD_SIMD_X86)
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+//index of the lowest set bit; mask must not be 0
+inline unsigned simd_ctz(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#elif defined(MYSTD_SIMD_X86)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return idx;
+#else
+    unsigned idx = 0;
+    for (; !(mask & 1u); mask >>= 1)
+        ++idx;
+    return idx;
+#endif
+}
+
+inline unsigned simd_popcount(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(mask);
+#else
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#endif
+}
+
+#ifdef MYSTD_SIMD_X86
+
+inline bool cpu_has_avx2() {
+    static const bool has_avx2 = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        //the OS has to save the ymm registers as well
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }();
+    return has_avx2;
+}
+
+//the bits of a value of the same size, without breaking aliasing rules
+template <typename Int>
+Int load(const void* p) {
+    Int bits;
+    std::memcpy(&bits, p, sizeof(bits));
+    return bits;
+}
+
+//128-bit lanes
+template <std::size_t Size> struct sse2_ops;
+
+template <> struct sse2_ops<1> {
+    static __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+    static __m128i set1(const void* p) { return _mm_set1_epi8(load<char>(p)); }
+};
+
+template <> struct sse2_ops<2> {
+    static __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+    static __m128i set1(const void* p) { return _mm_set1_epi16(load<short>(p)); }
+};
+
+template <> struct sse2_ops<4> {
+    static __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+    static __m128i set1(const void* p) { return _mm_set1_epi32(load<int>(p)); }
+};
+
+//SSE2 has no 64-bit compare: both 32-bit halves have to match
+template <> struct sse2_ops<8> {
+    static __m128i eq(__m128i a, __m128i b) {
+        const __m128i eq32 = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+    static __m128i set1(const void* p) { return _mm_set1_epi64x(load<long long>(p)); }
+};
+
+//256-bit lanes
+template <std::size_t Size> struct avx2_ops;
+
+template <> struct avx2_ops<1> {
+    MYSTD_TARGET_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi8(a, b); }
+    MYSTD_TARGET_AVX2 static __m256i set1(const void* p) { return _mm256_set1_epi8(load<char>(p)); }
+};
+
+template <> struct avx2_ops<2> {
+    MYSTD_TARGET_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(a, b); }
+    MYSTD_TARGET_AVX2 static __m256i set1(const void* p) { return _mm256_set1_epi16(load<short>(p)); }
+};
+
+template <> struct avx2_ops<4> {
+    MYSTD_TARGET_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+    MYSTD_TARGET_AVX2 static __m256i set1(const void* p) { return _mm256_set1_epi32(load<int>(p)); }
+};
+
+template <> struct avx2_ops<8> {
+    MYSTD_TARGET_AVX2 static __m256i eq(__m256i a, __m256i b) { return _mm256_cmpeq_epi64(a, b); }
+    MYSTD_TARGET_AVX2 static __m256i set1(const void* p) { return _mm256_set1_epi64x(load<long long>(p)); }
+};
+
+template <typename T>
+const T* find_sse2(const T* first, const T* last, const T& value) {
+    using ops = sse2_ops<sizeof(T)>;
+    const std::size_t STEP = sizeof(__m128i) / sizeof(T);
+    const __m128i needle = ops::set1(&value);
+    for (; last - first >= static_cast<std::ptrdiff_t>(STEP); first += STEP) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const unsigned mask = _mm_movemask_epi8(ops::eq(block, needle));
+        if (mask)
+            return first + simd_ctz(mask) / sizeof(T);
+    }
+    for (; first != last && *first != value; ++first) {}
+    return first;
+}
+
+template <typename T>
+MYSTD_TARGET_AVX2 const T* find_avx2(const T* first, const T* last, const T& value) {
+    using ops = avx2_ops<sizeof(T)>;
+    const std::size_t STEP = sizeof(__m256i) / sizeof(T);
+    const __m256i needle = ops::set1(&value);
+    for (; last - first >= static_cast<std::ptrdiff_t>(STEP); first += STEP) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const unsigned mask = _mm256_movemask_epi8(ops::eq(block, needle));
+        if (mask)
+            return first + simd_ctz(mask) / sizeof(T);
+    }
+    for (; first != last && *first != value; ++first) {}
+    return first;
+}
+
+template <typename T>
+std::ptrdiff_t count_sse2(const T* first, const T* last, const T& value) {
+    using ops = sse2_ops<sizeof(T)>;
+    const std::size_t STEP = sizeof(__m128i) / sizeof(T);
+    const __m128i needle = ops::set1(&value);
+    std::ptrdiff_t bytes = 0;
+    for (; last - first >= static_cast<std::ptrdiff_t>(STEP); first += STEP) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        bytes += simd_popcount(_mm_movemask_epi8(ops::eq(block, needle)));
+    }
+    std::ptrdiff_t n = bytes / static_cast<std::ptrdiff_t>(sizeof(T));
+    for (; first != last; ++first)
+        n += *first == value;
+    return n;
+}
+
+template <typename T>
+MYSTD_TARGET_AVX2 std::ptrdiff_t count_avx2(const T* first, const T* last, const T& value) {
+    using ops = avx2_ops<sizeof(T)>;
+    const std::size_t STEP = sizeof(__m256i) / sizeof(T);
+    const __m256i needle = ops::set1(&value);
+    std::ptrdiff_t bytes = 0;
+    for (; last - first >= static_cast<std::ptrdiff_t>(STEP); first += STEP) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        bytes += simd_popcount(static_cast<unsigned>(_mm256_movemask_epi8(ops::eq(block, needle))));
+    }
+    std::ptrdiff_t n = bytes / static_cast<std::ptrdiff_t>(sizeof(T));
+    for (; first != last; ++first)
+        n += *first == value;
+    return n;
+}
+
+//first position where [first1, last1) and the range at first2 differ, as an offset
+template <typename T>
+std::ptrdiff_t mismatch_sse2(const T* first1, const T* last1, const T* first2) {
+    using ops = sse2_ops<sizeof(T)>;
+    const std::size_t STEP = sizeof(__m128i) / sizeof(T);
+    const T* it = first1;
+    for (; last1 - it >= static_cast<std::ptrdiff_t>(STEP); it += STEP, first2 += STEP) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first2));
+        const unsigned diff = ~static_cast<unsigned>(_mm_movemask_epi8(ops::eq(a, b))) & 0xFFFFu;
+        if (diff)
+            return (it - first1) + static_cast<std::ptrdiff_t>(simd_ctz(diff) / sizeof(T));
+    }
+    for (; it != last1 && *it == *first2; ++it, ++first2) {}
+    return it - first1;
+}
+
+template <typename T>
+MYSTD_TARGET_AVX2 std::ptrdiff_t mismatch_avx2(const T* first1, const T* last1, const T* first2) {
+    using ops = avx2_ops<sizeof(T)>;
+    const std::size_t STEP = sizeof(__m256i) / sizeof(T);
+    const T* it = first1;
+    for (; last1 - it >= static_cast<std::ptrdiff_t>(STEP); it += STEP, first2 += STEP) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first2));
+        const unsigned diff = ~static_cast<unsigned>(_mm256_movemask_epi8(ops::eq(a, b)));
+        if (diff)
+            return (it - first1) + static_cast<std::ptrdiff_t>(simd_ctz(diff) / sizeof(T));
+    }
+    for (; it != last1 && *it == *first2; ++it, ++first2) {}
+    return it - first1;
+}
+
+template <typename T>
+const T* simd_find(const T* first, const T* last, const T& value) {
+    return cpu_has_avx2() ? find_avx2(first, last, value) : find_sse2(first, last, value);
+}
+
+template <typename T>
+std::ptrdiff_t simd_count(const T* first, const T* last, const T& value) {
+    return cpu_has_avx2() ? count_avx2(first, last, value) : count_sse2(first, last, value);
+}
+
+template <typename T>
+std::ptrdiff_t simd_mismatch(const T* first1, const T* last1, const T* first2) {
+    return cpu_has_avx2() ? mismatch_avx2(first1, last1, first2) : mismatch_sse2(first1, last1, first2);
+}
+
+#else
+
+//plain loops where no vector unit is used
+
+template <typename T>
+const T* simd_find(const T* first, const T* last, const T& value) {
+    for (; first != last && *first != value; ++first) {}
+    return first;
+}
+
+template <typename T>
+std::ptrdiff_t simd_count(const T* first, const T* last, const T& value) {
+    std::ptrdiff_t n = 0;
+    for (; first != last; ++first)
+        n += *first == value;
+    return n;
+}
+
+template <typename T>
+std::ptrdiff_t simd_mismatch(const T* first1, const T* last1, const T* first2) {
+    const T* it = first1;
+    for (; it != last1 && *it == *first2; ++it, ++first2) {}
+    return it - first1;
+}
+
+#endif
+
+}
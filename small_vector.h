@@ -0,0 +1,429 @@
+﻿#pragma once
+
+#include <memory>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+#include "iterator.h"
+#include "vector.h"
+
+namespace mystd {
+
+//A vector that keeps up to N elements in an inline buffer and only allocates once it grows beyond N.
+//It offers the interface of mystd::vector; iterators are raw pointers as well.
+template<typename T, std::size_t N, typename Allocator = allocator<T>>
+class small_vector : private vector_base<small_vector<T, N, Allocator>, T, Allocator> {
+    static_assert(N > 0, "small_vector needs an inline capacity of at least 1");
+    using base = vector_base<small_vector<T, N, Allocator>, T, Allocator>;
+    friend base;
+
+public:
+    using value_type =          T;
+    using allocator_type =      Allocator;
+    using pointer =             T*;
+    using const_pointer =       const T*;
+    using reference =           T&;
+    using const_reference =     const T&;
+    using iterator =            T*;
+    using const_iterator =      const T*;
+    using size_type =           std::size_t;
+    using difference_type =     std::ptrdiff_t;
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using relocate_tag = typename base::relocate_tag;
+    using base::destroyElem;
+    using base::relocate;
+    using base::insertN;
+    using base::insertRange;
+    using base::shiftErase;
+
+    Allocator alloc_;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type inline_[N];
+    pointer elem_ = inlineData(); //elements, either in inline_ or on the heap
+    pointer end_ = elem_; //point to position after last elem
+    pointer free_ = elem_ + N; //the first space after capacity
+
+private:
+    pointer inlineData() noexcept {
+        return reinterpret_cast<pointer>(inline_);
+    }
+
+    bool isInline() const noexcept {
+        return elem_ == const_cast<small_vector*>(this)->inlineData();
+    }
+
+    //give back the heap buffer, if any, and return to the empty inline buffer
+    void releaseStorage() {
+        if (!isInline())
+            alloc_traits::deallocate(alloc_, elem_, capacity());
+        elem_ = end_ = inlineData();
+        free_ = elem_ + N;
+    }
+
+    void clearMem() {
+        destroyElem(elem_, end_);
+        releaseStorage();
+    }
+
+    //switch to the buffer new_elem of new_capacity, which already holds new_size elements
+    void adoptStorage(pointer new_elem, size_type new_size, size_type new_capacity) {
+        if (!isInline())
+            alloc_traits::deallocate(alloc_, elem_, capacity());
+        elem_ = new_elem;
+        end_ = new_elem + new_size;
+        free_ = new_elem + new_capacity;
+    }
+
+    void expandCapacity(size_type new_capacity) {
+        if (new_capacity <= capacity())
+            return;
+
+        pointer new_elem_ = alloc_traits::allocate(alloc_, new_capacity);
+        try {
+            relocate(elem_, end_, new_elem_, relocate_tag());
+        }
+        catch (...) {
+            alloc_traits::deallocate(alloc_, new_elem_, new_capacity);
+            throw;
+        }
+        adoptStorage(new_elem_, size(), new_capacity);
+    }
+
+    //take over the elements of other, which is left empty
+    void stealFrom(small_vector& other) {
+        if (other.isInline()) {
+            relocate(other.elem_, other.end_, elem_, relocate_tag());
+            end_ = elem_ + other.size();
+            other.end_ = other.elem_;
+        }
+        else {
+            elem_ = other.elem_;
+            end_ = other.end_;
+            free_ = other.free_;
+            other.elem_ = other.end_ = other.inlineData();
+            other.free_ = other.elem_ + N;
+        }
+    }
+
+public:
+    /******constructor******/
+    //default
+    small_vector() = default;
+
+    explicit small_vector(const allocator_type& alloc) : alloc_(alloc) {}
+
+    //fill
+    explicit small_vector(size_type n, const value_type& val = value_type(),
+        const allocator_type& alloc = allocator_type()) : alloc_(alloc) {
+        assign(n, val);
+    }
+
+    small_vector(const_iterator first, const_iterator last, const allocator_type& alloc = allocator_type()) :
+        alloc_(alloc) {
+        if (first > last)
+            throw std::out_of_range("at small_vector()");
+        assign(first, last);
+    }
+
+    small_vector(const small_vector& other) :
+        small_vector(other.cbegin(), other.cend(), alloc_traits::select_on_container_copy_construction(other.alloc_)) {}
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) :
+        alloc_(other.alloc_) {
+        stealFrom(other);
+    }
+
+    small_vector& operator=(const small_vector& other) {
+        if (&other == this)
+            return *this;
+        assign(other.cbegin(), other.cend());
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) {
+        if (&other == this)
+            return *this;
+        clearMem();
+        alloc_ = other.alloc_;
+        stealFrom(other);
+        return *this;
+    }
+
+    /******Destructor******/
+    ~small_vector() {
+        clearMem();
+    }
+
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return end_ - elem_;
+    }
+
+    size_type capacity() const noexcept {
+        return free_ - elem_;
+    }
+
+    bool empty() const noexcept {
+        return end_ == elem_;
+    }
+
+    //whether the elements live in the inline buffer
+    bool is_small() const noexcept {
+        return isInline();
+    }
+
+    static constexpr size_type inline_capacity() noexcept {
+        return N;
+    }
+
+    void reserve(size_type n) {
+        expandCapacity(n);
+    }
+
+    void resize(size_type n) {
+        resize(n, value_type());
+    }
+
+    void resize(size_type n, const value_type& val) {
+        if (n < size()) {
+            erase(begin() + n, end());
+        }
+        else if (n > size()) {
+            insert(end(), n - size(), val);
+        }
+    }
+
+    //move the elements back into the inline buffer, or into a tighter heap buffer
+    void shrink_to_fit() {
+        if (isInline() || size() == capacity())
+            return;
+        if (size() <= N) {
+            pointer old_elem = elem_;
+            const size_type old_size = size(), old_capacity = capacity();
+            relocate(old_elem, end_, inlineData(), relocate_tag());
+            alloc_traits::deallocate(alloc_, old_elem, old_capacity);
+            elem_ = inlineData();
+            end_ = elem_ + old_size;
+            free_ = elem_ + N;
+            return;
+        }
+        pointer new_elem_ = alloc_traits::allocate(alloc_, size());
+        try {
+            relocate(elem_, end_, new_elem_, relocate_tag());
+        }
+        catch (...) {
+            alloc_traits::deallocate(alloc_, new_elem_, size());
+            throw;
+        }
+        adoptStorage(new_elem_, size(), size());
+    }
+
+    /******Element access******/
+    reference operator[](size_type index) {
+        return elem_[index];
+    }
+
+    const_reference operator[](size_type index) const {
+        return elem_[index];
+    }
+
+    reference at(size_type index) {
+        if (index >= size())
+            throw std::out_of_range("at small_vector::at()");
+        return elem_[index];
+    }
+
+    const_reference at(size_type index) const {
+        return const_cast<small_vector*>(this)->at(index);
+    }
+
+    reference front() {
+        return *begin();
+    }
+
+    const_reference front() const {
+        return *begin();
+    }
+
+    reference back() {
+        if (empty())
+            throw std::out_of_range("at small_vector::back()");
+        return *(end_ - 1);
+    }
+
+    const_reference back() const {
+        return const_cast<small_vector*>(this)->back();
+    }
+
+    pointer data() noexcept {
+        return elem_;
+    }
+
+    const_pointer data() const noexcept {
+        return elem_;
+    }
+
+    /******iterator******/
+    iterator begin() noexcept {
+        return elem_;
+    }
+
+    const_iterator begin() const noexcept {
+        return elem_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return elem_;
+    }
+
+    iterator end() noexcept {
+        return end_;
+    }
+
+    const_iterator end() const noexcept {
+        return end_;
+    }
+
+    const_iterator cend() const noexcept {
+        return end_;
+    }
+
+    /******Modifiers******/
+    void push_back(const value_type& val) {
+        emplace_back(val);
+    }
+
+    void push_back(value_type&& val) {
+        emplace_back(std::move(val));
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        if (end_ != free_) {
+            alloc_traits::construct(alloc_, end_, std::forward<Args>(args)...);
+            ++end_;
+        }
+        else {
+            //the new element is built before the old ones are relocated, so args may refer into *this
+            insertN(end_, 1, [&](pointer dest) { alloc_traits::construct(alloc_, dest, std::forward<Args>(args)...); });
+        }
+        return back();
+    }
+
+    void pop_back() {
+        if (empty())
+            throw std::out_of_range("at small_vector::pop_back()");
+        alloc_traits::destroy(alloc_, --end_);
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator position, Args&&... args) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at small_vector::emplace()");
+        if (position == cend()) {
+            const difference_type idx = position - cbegin();
+            emplace_back(std::forward<Args>(args)...);
+            return begin() + idx;
+        }
+        //args may refer to an element that is about to be shifted
+        value_type val(std::forward<Args>(args)...);
+        return insert(position, std::move(val));
+    }
+
+    iterator insert(const_iterator position, const value_type& val) {
+        value_type val_ = val;
+        return insert(position, std::move(val_));
+    }
+
+    iterator insert(const_iterator position, size_type n, const value_type& val) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at small_vector::insert()");
+        const value_type copy = val;
+        return insertN(const_cast<iterator>(position), n,
+            [&](pointer dest) { std::uninitialized_fill_n(dest, n, copy); });
+    }
+
+    iterator insert(const_iterator position, value_type&& val) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at small_vector::insert()");
+        return insertN(const_cast<iterator>(position), 1,
+            [&](pointer dest) { alloc_traits::construct(alloc_, dest, std::move(val)); });
+    }
+
+    //[first, last)
+    template<typename InputIterator,
+        typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    iterator insert(const_iterator position, InputIterator first, InputIterator last) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at small_vector::insert()");
+        return insertRange(const_cast<iterator>(position), first, last,
+            std::integral_constant<bool, is_forward_iterator<InputIterator>::value>());
+    }
+
+    void assign(size_type n, const value_type& val) {
+        const value_type copy = val;
+        if (n > capacity()) {
+            clearMem();
+            expandCapacity(n);
+        }
+        if (n > size()) {
+            std::fill(elem_, end_, copy);
+            std::uninitialized_fill_n(end_, n - size(), copy);
+        }
+        else {
+            std::fill_n(elem_, n, copy);
+            destroyElem(elem_ + n, end_);
+        }
+        end_ = elem_ + n;
+    }
+
+    template<typename InputIterator,
+        typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    void assign(InputIterator first, InputIterator last) {
+        clear();
+        insert(cend(), first, last);
+    }
+
+    //[first, last)
+    iterator erase(const_iterator first, const_iterator last) {
+        if (first < cbegin() || last > cend() || first > last)
+            throw std::out_of_range("at small_vector::erase()");
+        return shiftErase(const_cast<iterator>(first), const_cast<iterator>(last), relocate_tag());
+    }
+
+    iterator erase(const_iterator position) {
+        return erase(position, position + 1);
+    }
+
+    //keeps the capacity, like mystd::vector
+    void clear() noexcept {
+        destroyElem(elem_, end_);
+        end_ = elem_;
+    }
+
+    void swap(small_vector& other) {
+        if (&other == this)
+            return;
+        if (!isInline() && !other.isInline()) {
+            using std::swap;
+            swap(alloc_, other.alloc_);
+            std::swap(elem_, other.elem_);
+            std::swap(end_, other.end_);
+            std::swap(free_, other.free_);
+            return;
+        }
+        small_vector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+};
+
+}
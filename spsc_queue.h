@@ -0,0 +1,225 @@
+﻿#pragma once
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+
+/*
+* spsc_queue: a bounded lock-free queue from one producer thread to one consumer thread.
+*
+* The elements sit in a power-of-two array between head_, advanced by the consumer, and
+* tail_, advanced by the producer; both only count up and are masked to a slot. Each side
+* writes only its own index, publishes with a release store and reads the other index
+* with an acquire load, so there is no read-modify-write and no lock anywhere.
+*
+* Each side also keeps the last value it read of the other side's index, and reads the
+* shared one again only when the cached value says the queue is full (producer) or empty
+* (consumer). In steady state a push or a pop touches no cache line the other side writes,
+* except the slot itself. try_push_n and try_pop_n move a batch with a single store.
+*
+* Exactly one thread may call the producer functions (try_push, try_emplace, try_push_n)
+* and exactly one the consumer functions (try_pop, try_pop_n, front, pop), at any time.
+*/
+namespace mystd {
+
+template<typename T, typename Allocator = std::allocator<T>>
+class spsc_queue {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using pointer = T*;
+    using size_type = std::size_t;
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    static const size_type CACHE_LINE_SIZE = 64;
+
+    //fixed at construction, read by both sides
+    Allocator alloc_;
+    pointer slots_ = nullptr;
+    size_type capacity_ = 0; //a power of two
+
+    //a full line of padding around each side's fields, so the producer's stores never
+    //invalidate the consumer's line and the other way round; plain char arrays rather than
+    //alignas(64), which operator new does not honour before C++17
+    char padding0_[CACHE_LINE_SIZE];
+
+    //written by the producer
+    std::atomic<size_type> tail_{ 0 };
+    size_type cached_head_ = 0;
+
+    char padding1_[CACHE_LINE_SIZE];
+
+    //written by the consumer
+    std::atomic<size_type> head_{ 0 };
+    size_type cached_tail_ = 0;
+
+    char padding2_[CACHE_LINE_SIZE];
+
+private:
+    pointer slot(size_type index) const noexcept {
+        return slots_ + (index & (capacity_ - 1));
+    }
+
+    static size_type roundCapacity(size_type n) {
+        size_type cap = 1;
+        while (cap < n) {
+            if (cap > (static_cast<size_type>(-1) >> 1))
+                throw std::length_error("at mystd::spsc_queue, capacity too large");
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    //free slots for the producer at tail, reading head_ only if the cached value shows fewer than n
+    size_type freeSlots(size_type tail, size_type n) noexcept {
+        size_type free = capacity_ - (tail - cached_head_);
+        if (free < n) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free = capacity_ - (tail - cached_head_);
+        }
+        return free;
+    }
+
+    //elements for the consumer at head, reading tail_ only if the cached value shows fewer than n
+    size_type readySlots(size_type head, size_type n) noexcept {
+        size_type ready = cached_tail_ - head;
+        if (ready < n) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            ready = cached_tail_ - head;
+        }
+        return ready;
+    }
+
+public:
+    /******constructor, destructor******/
+    //the capacity is rounded up to a power of two
+    explicit spsc_queue(size_type capacity, const Allocator& alloc = Allocator()) :alloc_(alloc) {
+        capacity_ = roundCapacity(capacity);
+        slots_ = alloc_traits::allocate(alloc_, capacity_);
+    }
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    //no thread may be using the queue any more
+    ~spsc_queue() {
+        const size_type tail = tail_.load(std::memory_order_acquire);
+        for (size_type i = head_.load(std::memory_order_relaxed); i != tail; ++i)
+            alloc_traits::destroy(alloc_, slot(i));
+        alloc_traits::deallocate(alloc_, slots_, capacity_);
+    }
+
+    /******Capacity******/
+    size_type capacity() const noexcept {
+        return capacity_;
+    }
+
+    //exact only when neither side is running
+    size_type size() const noexcept {
+        const size_type head = head_.load(std::memory_order_acquire);
+        const size_type tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /******Producer******/
+    //false, and nothing is built, when the queue is full
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        const size_type tail = tail_.load(std::memory_order_relaxed);
+        if (freeSlots(tail, 1) == 0)
+            return false;
+        alloc_traits::construct(alloc_, slot(tail), std::forward<Args>(args)...);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const value_type& val) {
+        return try_emplace(val);
+    }
+
+    bool try_push(value_type&& val) {
+        return try_emplace(std::move(val));
+    }
+
+    //push up to n elements from first, as many as fit, and publish them at once; returns how many
+    template<typename InputIterator>
+    size_type try_push_n(InputIterator first, size_type n) {
+        const size_type tail = tail_.load(std::memory_order_relaxed);
+        const size_type free = freeSlots(tail, n);
+        if (n > free)
+            n = free;
+        size_type i = 0;
+        try {
+            for (; i < n; ++i, ++first)
+                alloc_traits::construct(alloc_, slot(tail + i), *first);
+        }
+        catch (...) {
+            //the elements built so far are kept
+            tail_.store(tail + i, std::memory_order_release);
+            throw;
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /******Consumer******/
+    //the oldest element, left in the queue, or nullptr if it is empty
+    pointer front() noexcept {
+        const size_type head = head_.load(std::memory_order_relaxed);
+        if (readySlots(head, 1) == 0)
+            return nullptr;
+        return slot(head);
+    }
+
+    //remove the element front() returned
+    void pop() {
+        const size_type head = head_.load(std::memory_order_relaxed);
+        if (readySlots(head, 1) == 0)
+            throw std::out_of_range("at mystd::spsc_queue::pop()");
+        alloc_traits::destroy(alloc_, slot(head));
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    //false, and val is untouched, when the queue is empty
+    bool try_pop(value_type& val) {
+        const size_type head = head_.load(std::memory_order_relaxed);
+        if (readySlots(head, 1) == 0)
+            return false;
+        val = std::move(*slot(head));
+        alloc_traits::destroy(alloc_, slot(head));
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //move up to n elements to out and free their slots at once; returns how many
+    template<typename OutputIterator>
+    size_type try_pop_n(OutputIterator out, size_type n) {
+        const size_type head = head_.load(std::memory_order_relaxed);
+        const size_type ready = readySlots(head, n);
+        if (n > ready)
+            n = ready;
+        size_type i = 0;
+        try {
+            for (; i < n; ++i, ++out) {
+                *out = std::move(*slot(head + i));
+                alloc_traits::destroy(alloc_, slot(head + i));
+            }
+        }
+        catch (...) {
+            //the element that failed to move stays at the front
+            head_.store(head + i, std::memory_order_release);
+            throw;
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+};
+
+}
@@ -1,85 +1,123 @@
-﻿#pragma once
-
-namespace mystd {
-	
-	template<typename T>
-	class stack {
-	private:
-		class Node {
-			friend class stack;
-		private:
-			T data;
-			Node* next;
-			Node* prev;
-		public:
-			Node() :next(nullptr), prev(nullptr) {}
-			Node(T _data) :Node(_data, nullptr, nullptr) {}
-			Node(T _data, Node* _next, Node* _prev) :data(_data), next(next), prev(_prev) {}
-		};
-
-
-	private:
-		//封装链表，头节点做栈底，尾节点为栈顶
-		Node* head;
-		Node* tail;
-		size_t stackSize;
-
-	public:
-		stack() :head(nullptr), tail(nullptr), stackSize(0) {}
-		~stack() {
-			while (head) {
-				Node* p = head;
-				head = head->next;
-				delete p;
-			}
-			head = tail = nullptr;
-			stackSize = 0;
-		}
-
-		size_t size()const noexcept { return stackSize; }
-		bool empty()const noexcept { return stackSize == 0; }
-
-		void push(const T& value) {
-			if (empty()) {
-				head = tail = new Node(value);
-				stackSize++;
-				return;
-			}
-			tail->next = new Node(value, nullptr, tail);
-			tail = tail->next;
-			stackSize++;
-		}
-
-		void push(T&& value) {
-			if (empty()) {
-				head = tail = new Node(value);
-				stackSize++;
-				return;
-			}
-			tail->next = new Node(value, nullptr, tail);
-			tail = tail->next;
-			stackSize++;
-		}
-
-		void pop() {
-			stackSize--;
-			if (empty()) {
-				delete tail;
-				tail = head = nullptr;
-				return;
-			}
-			Node* p = tail;
-			tail = tail->prev;
-			tail->next = nullptr;
-			delete p;
-		}
-
-		T& top() {
-			if (!empty())
-				return tail->data;
-			throw std::out_of_range("at top()");
-		}
-
-	};
-}
-
+﻿#pragma once
+#include <memory>
+#include "allocator.h"
+
+namespace mystd {
+	
+	template<typename T, typename Allocator = std::allocator<T>>
+	class stack {
+	public:
+		using allocator_type = Allocator;
+
+	private:
+		class Node {
+			friend class stack;
+		private:
+			T data;
+			Node* next;
+			Node* prev;
+		public:
+			Node() :next(nullptr), prev(nullptr) {}
+			Node(T _data) :Node(_data, nullptr, nullptr) {}
+			Node(T _data, Node* _next, Node* _prev) :data(_data), next(_next), prev(_prev) {}
+		};
+
+
+	private:
+		using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+		using node_traits = std::allocator_traits<node_allocator>;
+
+		template<typename... Args>
+		Node* createNode(Args&&... args) {
+			Node* p = cache_.allocate(alloc_);
+			try {
+				node_traits::construct(alloc_, p, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				cache_.deallocate(alloc_, p);
+				throw;
+			}
+			return p;
+		}
+
+		//the memory is kept for the next createNode
+		void destroyNode(Node* p) {
+			node_traits::destroy(alloc_, p);
+			cache_.deallocate(alloc_, p);
+		}
+
+		//封装链表，头节点做栈底，尾节点为栈顶
+		Node* head;
+		Node* tail;
+		size_t stackSize;
+		node_allocator alloc_;
+		node_cache<node_allocator> cache_;
+
+	public:
+		stack() :stack(Allocator()) {}
+		explicit stack(const Allocator& alloc) :head(nullptr), tail(nullptr), stackSize(0), alloc_(alloc) {}
+		~stack() {
+			while (head) {
+				Node* p = head;
+				head = head->next;
+				destroyNode(p);
+			}
+			head = tail = nullptr;
+			stackSize = 0;
+			cache_.release(alloc_);
+		}
+
+		size_t size()const noexcept { return stackSize; }
+		bool empty()const noexcept { return stackSize == 0; }
+
+		void push(const T& value) {
+			if (empty()) {
+				head = tail = createNode(value);
+				stackSize++;
+				return;
+			}
+			tail->next = createNode(value, nullptr, tail);
+			tail = tail->next;
+			stackSize++;
+		}
+
+		void push(T&& value) {
+			if (empty()) {
+				head = tail = createNode(value);
+				stackSize++;
+				return;
+			}
+			tail->next = createNode(value, nullptr, tail);
+			tail = tail->next;
+			stackSize++;
+		}
+
+		void pop() {
+			stackSize--;
+			if (empty()) {
+				destroyNode(tail);
+				tail = head = nullptr;
+				return;
+			}
+			Node* p = tail;
+			tail = tail->prev;
+			tail->next = nullptr;
+			destroyNode(p);
+		}
+
+		T& top() {
+			if (!empty())
+				return tail->data;
+			throw std::out_of_range("at top()");
+		}
+
+		/******Node cache******/
+		//erased nodes are kept for reuse, at most max_cached_nodes() of them; unlimited by default
+		size_t max_cached_nodes() const noexcept { return cache_.max_cached(); }
+		void max_cached_nodes(size_t n) { cache_.max_cached(alloc_, n); }
+		//free the cached nodes
+		void shrink_to_fit() { cache_.release(alloc_); }
+
+	};
+}
+
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <functional>
+#include <cstdint>
+#include "iterator.h"
+#include "vector.h"
+#include "simd.h"
+
+namespace mystd {
+
+/*
+A read-only set of sorted values laid out for fast lookups (Eytzinger layout).
+
+The values are stored in the order of a breadth-first walk of the implicit binary search
+tree: the root at 1 and the children of k at 2k and 2k+1. The first levels, which every
+search visits, share a few cache lines, and the 2^d descendants of k d levels down are
+contiguous from k * 2^d, so they are prefetched while the current level is compared; d is
+4 for 4-byte values, 3 for 8-byte ones, and in general the deepest level, up to 4, whose
+block still fits in a cache line (at least 1). Each step is k = 2k + (tree[k] < value),
+without a branch.
+
+Results are pointers to elements inside the index, or nullptr when there is none.
+
+mystd::static_search_index<int> index(sorted.begin(), sorted.end());
+if (const int* p = index.lower_bound(42)) ...
+*/
+template<typename T, typename Compare = std::less<T>, typename Allocator = allocator<T>>
+class static_search_index {
+public:
+    using value_type =          T;
+    using key_compare =         Compare;
+    using allocator_type =      Allocator;
+    using const_pointer =       const T*;
+    using size_type =           std::size_t;
+
+private:
+    //levels the search prefetches ahead: as many as keep the 2^PREFETCH_DEPTH descendants within
+    //a 64-byte line, and at least one
+    static const unsigned PREFETCH_DEPTH = sizeof(T) <= 4 ? 4 : sizeof(T) <= 8 ? 3 : sizeof(T) <= 16 ? 2 : 1;
+
+    vector<T, Allocator> tree_; //tree_[0] is padding, the root is tree_[1]
+    Compare comp_;
+
+private:
+    //copy sorted values in order into the tree rooted at k; returns the next unused value
+    template<typename RandomAccessIterator>
+    RandomAccessIterator build(RandomAccessIterator sorted, size_type k) {
+        if (k < tree_.size()) {
+            sorted = build(sorted, 2 * k);
+            tree_[k] = *sorted++;
+            sorted = build(sorted, 2 * k + 1);
+        }
+        return sorted;
+    }
+
+    //walk down while less(node) says to go right; the answer is the last node where the walk went left
+    template<typename Less>
+    const_pointer descend(Less less) const {
+        const_pointer tree = tree_.begin();
+        const size_type n = size();
+        size_type k = 1;
+        while (k <= n) {
+            mystd::prefetch(reinterpret_cast<const void*>(
+                reinterpret_cast<std::uintptr_t>(tree) + (k << PREFETCH_DEPTH) * sizeof(T)));
+            k = 2 * k + (less(tree[k]) ? 1 : 0);
+        }
+        //strip the right turns taken after the last left turn, then the left turn itself
+        while (k & 1)
+            k >>= 1;
+        k >>= 1;
+        return k ? tree + k : nullptr;
+    }
+
+public:
+    explicit static_search_index(const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : tree_(alloc), comp_(comp) {}
+
+    //[first, last) must be sorted by comp
+    template<typename InputIterator>
+    static_search_index(InputIterator first, InputIterator last,
+        const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : tree_(alloc), comp_(comp) {
+        vector<T, Allocator> sorted(alloc);
+        sorted.insert(sorted.end(), first, last);
+        if (sorted.empty())
+            return;
+        tree_.reserve(sorted.size() + 1);
+        tree_.insert(tree_.end(), sorted.size() + 1, sorted[0]);
+        build(sorted.cbegin(), 1);
+    }
+
+    size_type size() const noexcept {
+        return tree_.empty() ? 0 : tree_.size() - 1;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    //the first element not less than value
+    const_pointer lower_bound(const T& value) const {
+        const Compare& comp = comp_;
+        return descend([&](const T& elem) { return comp(elem, value); });
+    }
+
+    //the first element greater than value
+    const_pointer upper_bound(const T& value) const {
+        const Compare& comp = comp_;
+        return descend([&](const T& elem) { return !comp(value, elem); });
+    }
+
+    const_pointer find(const T& value) const {
+        const_pointer p = lower_bound(value);
+        return p && !comp_(value, *p) ? p : nullptr;
+    }
+
+    bool contains(const T& value) const {
+        return find(value) != nullptr;
+    }
+
+    key_compare key_comp() const {
+        return comp_;
+    }
+
+    allocator_type get_allocator() const {
+        return tree_.get_allocator();
+    }
+};
+
+}
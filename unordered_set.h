@@ -1,421 +1,800 @@
-﻿#pragma once
-#include <forward_list>
-#include <vector>
-#include <utility>
-#include <algorithm>
-#include "vector.h"
-#include "iterator.h"
-#include "algorithm.h"
-
-//#define USING_STD_VECTOR
-#define USING_STD_LIST
-
-
-namespace mystd {
-
-template<typename T, typename Hash = std::hash <T>, typename Equal = std::equal_to<T>>
-class unordered_set {
-private:
-#ifdef USING_STD_LIST
-    using bucket_type = std::forward_list<T>;
-#else
-    using bucket_type = mystd::vector<T>;
-#endif
-
-#ifdef USING_STD_VECTOR
-    using vector_type = std::vector<bucket_type>;
-#else
-    using vector_type = mystd::vector<bucket_type>;
-#endif
-
-public:
-    using key_type = T;
-    using value_type = T;
-    using pointer = T*;
-    using const_pointer = const T*;
-    using reference = T&;
-    using const_reference = const T&;
-    using size_type = std::size_t;
-    using difference_type = std::ptrdiff_t;
-    using hasher = Hash;
-    using key_equal = Equal;
-    using local_iterator = typename bucket_type::const_iterator;
-    using const_local_iterator = typename bucket_type::const_iterator;
-
-public:
-
-    class const_iterator {
-        friend class unordered_set;
-    public:
-        using value_type = T;
-        using pointer = const T*;
-        using reference = const T&;
-        using difference_type = std::ptrdiff_t;
-        using iterator_category = mystd::forward_iterator_tag;
-
-    public:
-        const_iterator() :ptr_(nullptr), bucket_idx_(0) {}
-
-        reference operator*() const {
-            return *iter_;
-        }
-
-        pointer operator->() const {
-            return &(operator*());
-        }
-
-        const_iterator& operator++() noexcept {
-            ++iter_;
-            while (bucket_idx_ < ptr_->size() && iter_ == (*ptr_)[bucket_idx_].cend()) {
-                if(++bucket_idx_ < ptr_->size())
-                    iter_ = (*ptr_)[bucket_idx_].cbegin();
-            }
-            return *this;
-        }
-
-        const_iterator operator++(int) noexcept {
-            const_iterator ret = *this;
-            ++(*this);
-            return ret;
-        }
-
-        bool operator==(const const_iterator& other) const noexcept {
-            return ptr_ == other.ptr_ && bucket_idx_ == other.bucket_idx_ && iter_ == other.iter_;
-        }
-
-        bool operator!=(const const_iterator& other) const noexcept {
-            return !(*this == other);
-        }
-
-    protected:
-        const_iterator(vector_type* ptr, bool is_end):ptr_(ptr) {
-            if (is_end) {
-                bucket_idx_ = ptr_->size();
-                if (!ptr_->empty())
-                    iter_ = (*ptr_)[bucket_idx_ - 1].cend();
-            }
-            
-            else {
-                bucket_idx_ = 0;
-                iter_ = (*ptr)[bucket_idx_].cbegin();
-                while (bucket_idx_ < ptr_->size() && iter_ == (*ptr_)[bucket_idx_].cend()) {
-                    if (++bucket_idx_ < ptr_->size())
-                        iter_ = (*ptr_)[bucket_idx_].cbegin();
-                }
-            }
-        }
-
-        const_iterator(vector_type* ptr, size_type bucket_idx, local_iterator iter) :
-            ptr_(ptr), bucket_idx_(bucket_idx), iter_(iter) {}
-
-    private:
-        vector_type* ptr_;
-        size_type bucket_idx_;
-        local_iterator iter_;
-    };
-
-    //key in unordered_set cannot be changed
-    using iterator = const_iterator;
-
-private:
-    hasher hash_;
-    key_equal equal_;
-    vector_type buckets_;
-    size_type size_ = 0;
-    float max_load_factor_ = 1.0; //Max average no. of elements per bucket
-    float growth_factor_ = 2.0; //expand factor
-
-    static const size_type PRIME_ARR_SIZE = 28;
-    static const size_type prime_[PRIME_ARR_SIZE];
-
-    size_type next_prime(size_type n)const {
-        const size_type* prime_arr_end = std::end(prime_);
-        const size_type* prime_ptr = std::lower_bound(prime_, prime_arr_end, n);
-        if (prime_ptr != prime_arr_end)
-            return *prime_ptr;
-        else
-            return prime_[PRIME_ARR_SIZE - 1];
-    }
-
-public:
-    /******constructor, destructor and copy******/
-    //default and empty
-    unordered_set() :unordered_set(static_cast<size_type>(0)) {}
-
-    explicit unordered_set(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal()) :
-        buckets_(next_prime(n), bucket_type()), hash_(hf), equal_(eql) {}
-
-    //copy
-    unordered_set(const unordered_set& other) :
-        buckets_(other.buckets_), size_(other.size_), max_load_factor_(other.max_load_factor_) {}
-
-    //move
-    unordered_set(unordered_set&& other) noexcept {
-        swap(other);
-    }
-//TO DO: range, initializer list
-
-    unordered_set& operator=(const unordered_set& other) {
-        if (this == &other)
-            return *this;
-        unordered_set copy(other);
-        swap(copy);
-        return *this;
-    }
-
-    unordered_set& operator=(unordered_set&& other) noexcept {
-        if (this == &other)
-            return *this;
-        swap(other);
-        return *this;
-    }
-//TO DO: initializer list
-
-    ~unordered_set() = default;
-
-    /******Capacity******/
-    size_type size() const noexcept {
-        return size_;
-    }
-
-    size_type max_size()const noexcept {
-        return prime_[PRIME_ARR_SIZE - 1];
-    }
-
-    bool empty() const noexcept {
-        return size_ == 0;
-    }
-
-    /******Iterators******/
-    //container iterator
-    iterator begin() noexcept {
-        return const_iterator(&buckets_, false);
-    }
-
-    const_iterator begin()const noexcept {
-        return const_cast<unordered_set*>(this)->begin();
-    }
-
-    iterator end() noexcept {
-        return const_iterator(&buckets_, true);
-    }
-
-    const_iterator end()const noexcept {
-        return const_cast<unordered_set*>(this)->end();
-    }
-
-    const_iterator cbegin()const noexcept {
-        return begin();
-    }
-
-    const_iterator cend()const noexcept {
-        return end();
-    }
-
-    //bucket iterator
-    //Returns an iterator pointing to the first element in one of its buckets
-    local_iterator begin(size_type n) {
-        return buckets_[n].begin();
-    }
-
-    const_local_iterator begin(size_type n)const {
-        return buckets_[n].begin();
-    }
-
-    local_iterator end(size_type n) {
-        return buckets_[n].end();
-    }
-
-    const_local_iterator end(size_type n)const {
-        return buckets_[n].end();
-    }
-
-    const_local_iterator cbegin(size_type n)const {
-        return buckets_[n].cbegin();
-    }
-
-    const_local_iterator cend(size_type n)const {
-        return buckets_[n].cend();
-    }
-
-    /******Element lookup******/
-    iterator find(const key_type& k) {
-        const size_type pos = bucket(k);
-        local_iterator iter = mystd::find(buckets_[pos].cbegin(), buckets_[pos].cend(), k);
-        if (iter != cend(pos))
-            return const_iterator(&buckets_, pos, iter);
-        else
-            return end();
-    }
-
-    const_iterator find(const key_type& k) const {
-        return const_cast<unordered_set*>(this)->find(k);
-    }
-
-    size_type count(const key_type& k) const {
-        const size_type pos = bucket(k);
-        local_iterator iter = mystd::find(buckets_[pos].cbegin(), buckets_[pos].cend(), k);
-        if (iter != cend(pos)) return 1;
-        else return 0;
-    }
-
-    std::pair<iterator, iterator> equal_range(const key_type& k) {
-        iterator ret = this->find(k);
-        return std::make_pair(ret, ret);
-    }
-
-    /******Modifiers******/
-//TO DO: insert(3)(4)(5)(6) in cpp reference, emplace
-
-    std::pair<iterator, bool> insert(const value_type& val) {
-        //rehash when necessary
-        
-        std::pair<bool, size_type> need_rh = need_rehash(size() + 1);
-        if (need_rh.first) {
-            rehash(need_rh.second);
-        }
-        
-        const size_type pos = bucket(val);
-        local_iterator iter = mystd::find(buckets_[pos].cbegin(), buckets_[pos].cend(), val);
-        //if the element exits
-        if (iter != cend(pos)) {
-            return std::make_pair(iterator(&buckets_, pos, iter), false);
-        }
-        //not found, then insert
-        else {
-            buckets_[pos].push_front(val);
-            ++size_;
-            return std::make_pair(iterator(&buckets_, pos, buckets_[pos].cbegin()), true);
-        }
-    }
-
-    std::pair<iterator, bool> insert(value_type&& val) {
-        const value_type copy = val;
-        return insert(copy);
-    }
-
-    iterator erase(const_iterator position) {
-        if (position == cend())
-            throw std::out_of_range("at mystd::unordered_set::erase()");
-
-        const value_type rm_val = *position;
-        const size_type idx = position.bucket_idx_;
-        ++position;
-        --size_;
-        buckets_[idx].remove(rm_val);
-        return position;
-    }
-
-    size_type erase(const key_type& k) {
-        const size_type pos = bucket(k);
-        local_iterator iter = mystd::find(buckets_[pos].cbegin(), buckets_[pos].cend(), k);
-        //if the element exits
-        if (iter == cend(pos)) {
-            return 0;
-        }
-        //not found, then insert
-        else {
-            buckets_[pos].remove(k);
-            --size_;
-            return 1;
-        }
-    }
-
-    iterator erase(const_iterator first, const_iterator last) {
-        const_iterator it = first;
-        while (it != last)
-            it = erase(it);
-        return last;
-    }
-
-    void swap(unordered_set& other) noexcept {
-        using std::swap;
-        buckets_.swap(other.buckets_);
-        swap(size_, other.size_);
-        swap(max_load_factor_, other.max_load_factor_);
-    }
-
-    void clear()noexcept {
-        buckets_.clear();
-        size_ = 0;
-    }
-
-    /******Buckets******/
-    size_type bucket_count()const noexcept {
-        return buckets_.size();
-    }
-
-    size_type max_bucket_count()const noexcept {
-        return prime_[PRIME_ARR_SIZE - 1];
-    }
-
-    //Returns the number of elements in bucket n
-    size_type bucket_size(size_type n) const {
-        return buckets_[n].size();
-    }
-
-    //Returns the bucket number where the element with value k is located
-    size_type bucket(const key_type& k) const {
-        return hash_(k) % bucket_count();
-    }
-
-    /******Hash policy******/
-    float load_factor()const noexcept {
-        return static_cast<float>(size()) / static_cast<float>(bucket_count());
-    }
-
-    float max_load_factor() const noexcept {
-        return max_load_factor_;
-    }
-
-    void max_load_factor(float z) {
-        max_load_factor_ = z;
-    }
-
-    void rehash(size_type n) {
-        if (n < bucket_count())
-            return;
-        const size_type new_bucket_cnt = next_prime(n);
-        if (new_bucket_cnt > bucket_count()) {
-            unordered_set expanded_copy(new_bucket_cnt);
-            for (const value_type& val : *this)
-                expanded_copy.insert(std::move(val));
-            buckets_.swap(expanded_copy.buckets_);
-        }
-    }
-
-    void reserve(size_type n) {
-        std::pair<bool, size_type> rh = need_rehash(n);
-        if (rh.first)
-            rehash(rh.second);
-    }
-
-private:
-    std::pair<bool, size_type> need_rehash(const size_type& next_size)const {
-        //refer to http://hustsxh.is-programmer.com/posts/82605.html
-        //need at least min buckets to contain size() + 1 elements
-        float min_bkts = static_cast<float>(next_size + 1) / max_load_factor_;
-        if (min_bkts > bucket_count()) {
-            min_bkts = mystd::max(min_bkts, growth_factor_ * size());
-            size_type next_resize = next_prime(min_bkts);
-            return std::make_pair(true, next_resize);
-        }
-        return std::make_pair(false, 0);
-    }
-
-};
-
-template <typename T, typename Hash, typename Equal>
-const typename unordered_set<T, Hash, Equal>::size_type
-unordered_set<T, Hash, Equal>::prime_[PRIME_ARR_SIZE] = {
-        53u, 97u, 193u, 389u, 769u, 1543u, 3079u, 6151u, 12289u, 24593u, 49157u,
-        98317u, 196613u, 393241u, 786433u, 1572869u, 3145739u, 6291469u, 12582917u,
-        25165843u, 50331653u, 100663319u, 201326611u, 402653189u, 805306457u,
-        1610612741u, 3221225473u, 4294967291u
-};
-
-}
-
-
-
-
+﻿#pragma once
+#include <forward_list>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include "vector.h"
+#include "iterator.h"
+#include "algorithm.h"
+#include "hash_policy.h"
+
+//#define USING_STD_VECTOR
+#define USING_STD_LIST
+
+
+namespace mystd {
+
+//what a bucket node holds: the element, and its hash code when Cached
+template<typename T, bool Cached>
+struct hash_node_value {
+    template<typename... Args>
+    explicit hash_node_value(std::size_t h, Args&&... args) :hash(h), value(std::forward<Args>(args)...) {}
+
+    std::size_t hash;
+    T value;
+};
+
+template<typename T>
+struct hash_node_value<T, false> {
+    template<typename... Args>
+    explicit hash_node_value(std::size_t, Args&&... args) :value(std::forward<Args>(args)...) {}
+
+    T value;
+};
+
+//hash codes are cached unless rehashing is cheaper than a word per node: integers, enums and pointers
+template<typename T>
+struct cache_hash_default : std::integral_constant<bool,
+    !(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value)> {};
+
+template<typename... Ts>
+struct make_void {
+    using type = void;
+};
+
+//Hash and Equal both declare is_transparent, so a K can be looked up without building a key
+template<typename Hash, typename Equal, typename K, typename = void>
+struct is_transparent_key : std::false_type {};
+
+template<typename Hash, typename Equal, typename K>
+struct is_transparent_key<Hash, Equal, K,
+    typename make_void<typename Hash::is_transparent, typename Equal::is_transparent, K>::type> : std::true_type {};
+
+/*
+BucketPolicy maps hashes to buckets, see hash_policy.h.
+CacheHash stores each element's hash in its node: rehashing then relinks nodes without calling
+Hash, and lookups compare the stored hash before calling Equal.
+*/
+template<typename T, typename Hash = std::hash <T>, typename Equal = std::equal_to<T>, typename Allocator = std::allocator<T>,
+    typename BucketPolicy = prime_fastmod_policy, bool CacheHash = cache_hash_default<T>::value>
+class unordered_set {
+private:
+    using node_value = hash_node_value<T, CacheHash>;
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node_value>;
+#ifdef USING_STD_LIST
+    using bucket_type = std::forward_list<node_value, node_allocator>;
+#else
+    using bucket_type = mystd::vector<node_value, node_allocator>;
+#endif
+    using node_iterator = typename bucket_type::const_iterator;
+    using cache_tag = std::integral_constant<bool, CacheHash>;
+    using bucket_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<bucket_type>;
+
+#ifdef USING_STD_VECTOR
+    using vector_type = std::vector<bucket_type, bucket_allocator>;
+#else
+    using vector_type = mystd::vector<bucket_type, bucket_allocator>;
+#endif
+
+public:
+    using key_type = T;
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+    using bucket_policy = BucketPolicy;
+
+public:
+
+    class const_local_iterator {
+        friend class unordered_set;
+    public:
+        using value_type = T;
+        using pointer = const T*;
+        using reference = const T&;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = mystd::forward_iterator_tag;
+
+    public:
+        const_local_iterator() {}
+
+        reference operator*() const {
+            return iter_->value;
+        }
+
+        pointer operator->() const {
+            return &(operator*());
+        }
+
+        const_local_iterator& operator++() noexcept {
+            ++iter_;
+            return *this;
+        }
+
+        const_local_iterator operator++(int) noexcept {
+            const_local_iterator ret = *this;
+            ++(*this);
+            return ret;
+        }
+
+        bool operator==(const const_local_iterator& other) const noexcept {
+            return iter_ == other.iter_;
+        }
+
+        bool operator!=(const const_local_iterator& other) const noexcept {
+            return !(*this == other);
+        }
+
+    protected:
+        explicit const_local_iterator(node_iterator iter) :iter_(iter) {}
+
+    private:
+        node_iterator iter_;
+    };
+
+    using local_iterator = const_local_iterator;
+
+    class const_iterator {
+        friend class unordered_set;
+    public:
+        using value_type = T;
+        using pointer = const T*;
+        using reference = const T&;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = mystd::forward_iterator_tag;
+
+    public:
+        const_iterator() :set_(nullptr), ptr_(nullptr), bucket_idx_(0) {}
+
+        reference operator*() const {
+            return iter_->value;
+        }
+
+        pointer operator->() const {
+            return &(operator*());
+        }
+
+        const_iterator& operator++() noexcept {
+            ++iter_;
+            skipEmpty();
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator ret = *this;
+            ++(*this);
+            return ret;
+        }
+
+        bool operator==(const const_iterator& other) const noexcept {
+            return ptr_ == other.ptr_ && bucket_idx_ == other.bucket_idx_ && iter_ == other.iter_;
+        }
+
+        bool operator!=(const const_iterator& other) const noexcept {
+            return !(*this == other);
+        }
+
+    protected:
+        const_iterator(const unordered_set* set, bool is_end) :set_(set) {
+            if (is_end) {
+                ptr_ = &set_->buckets_;
+                bucket_idx_ = ptr_->size();
+                if (!ptr_->empty())
+                    iter_ = (*ptr_)[bucket_idx_ - 1].cend();
+            }
+            
+            else {
+                //buckets not migrated yet are walked before the new table
+                ptr_ = set_->rehashing() ? &set_->old_buckets_ : &set_->buckets_;
+                bucket_idx_ = 0;
+                if (!ptr_->empty()) {
+                    iter_ = (*ptr_)[bucket_idx_].cbegin();
+                    skipEmpty();
+                }
+            }
+        }
+
+        const_iterator(const unordered_set* set, const vector_type* ptr, size_type bucket_idx, node_iterator iter) :
+            set_(set), ptr_(ptr), bucket_idx_(bucket_idx), iter_(iter) {}
+
+        //move past empty buckets, from the old table on to the new one
+        void skipEmpty() noexcept {
+            for (;;) {
+                while (bucket_idx_ < ptr_->size() && iter_ == (*ptr_)[bucket_idx_].cend()) {
+                    if (++bucket_idx_ < ptr_->size())
+                        iter_ = (*ptr_)[bucket_idx_].cbegin();
+                }
+                if (bucket_idx_ < ptr_->size() || ptr_ == &set_->buckets_)
+                    return;
+                ptr_ = &set_->buckets_;
+                bucket_idx_ = 0;
+                iter_ = (*ptr_)[bucket_idx_].cbegin();
+            }
+        }
+
+    private:
+        const unordered_set* set_;
+        const vector_type* ptr_; //the table holding iter_
+        size_type bucket_idx_;
+        node_iterator iter_;
+    };
+
+    //key in unordered_set cannot be changed
+    using iterator = const_iterator;
+
+private:
+    //keys hashed and prefetched together by find_batch and contains_batch
+    static const size_type BATCH_SIZE = 16;
+
+    hasher hash_;
+    key_equal equal_;
+    bucket_policy policy_;
+    vector_type buckets_;
+    size_type size_ = 0;
+    float max_load_factor_ = 1.0; //Max average no. of elements per bucket
+    float growth_factor_ = 2.0; //expand factor
+
+    //incremental rehash: the previous table, drained into buckets_ rehash_step_ buckets per insert
+    bucket_policy old_policy_;
+    vector_type old_buckets_; //empty unless a rehash is in progress
+    size_type migrate_pos_ = 0; //buckets of old_buckets_ before this one are empty
+    size_type rehash_step_ = 0; //0: rehash all at once
+
+    size_type hashOf(const node_value& node, std::true_type) const {
+        return node.hash;
+    }
+
+    size_type hashOf(const node_value& node, std::false_type) const {
+        return hash_(node.value);
+    }
+
+    //a stored hash that differs rules the node out without calling key_equal
+    template<typename K>
+    bool matches(const node_value& node, const K& k, size_type hash, std::true_type) const {
+        return node.hash == hash && equal_(node.value, k);
+    }
+
+    template<typename K>
+    bool matches(const node_value& node, const K& k, size_type, std::false_type) const {
+        return equal_(node.value, k);
+    }
+
+    void setHash(node_value& node, size_type hash, std::true_type) noexcept {
+        node.hash = hash;
+    }
+
+    void setHash(node_value&, size_type, std::false_type) noexcept {}
+
+    template<typename K>
+    node_iterator findNode(const bucket_type& bucket, const K& k, size_type hash) const {
+        node_iterator iter = bucket.cbegin();
+        for (; iter != bucket.cend() && !matches(*iter, k, hash, cache_tag()); ++iter) {}
+        return iter;
+    }
+
+    //the element equal to k, searched in the new table and then in the old one
+    template<typename K>
+    iterator locate(const K& k, size_type hash) const {
+        size_type pos = policy_.index(hash);
+        node_iterator iter = findNode(buckets_[pos], k, hash);
+        if (iter != buckets_[pos].cend())
+            return const_iterator(this, &buckets_, pos, iter);
+        if (rehashing()) {
+            pos = old_policy_.index(hash);
+            iter = findNode(old_buckets_[pos], k, hash);
+            if (iter != old_buckets_[pos].cend())
+                return const_iterator(this, &old_buckets_, pos, iter);
+        }
+        return end();
+    }
+
+    //relink the nodes of up to cnt old buckets into the new table
+    void migrateStep(size_type cnt) {
+        if (!rehashing())
+            return;
+        for (; cnt > 0 && migrate_pos_ < old_buckets_.size(); --cnt) {
+            bucket_type& from = old_buckets_[migrate_pos_++];
+            while (!from.empty()) {
+                bucket_type& to = buckets_[policy_.index(hashOf(from.front(), cache_tag()))];
+                to.splice_after(to.before_begin(), from, from.before_begin());
+            }
+        }
+        if (migrate_pos_ == old_buckets_.size()) {
+            vector_type drained(old_buckets_.get_allocator());
+            old_buckets_.swap(drained);
+            migrate_pos_ = 0;
+        }
+    }
+
+    void finishRehash() {
+        migrateStep(old_buckets_.size());
+    }
+
+    /*
+    Look keys up BATCH_SIZE at a time: hash the whole group and prefetch its buckets, then
+    prefetch the first node of every non-empty bucket, then resolve the group. The cache
+    misses of a group overlap instead of being paid one key after another.
+    */
+    template<typename ForwardIterator, typename OutputIterator, typename Emit>
+    OutputIterator lookupBatch(ForwardIterator first, ForwardIterator last, OutputIterator out, Emit emit) const {
+        size_type hashes[BATCH_SIZE];
+        size_type positions[BATCH_SIZE];
+        while (first != last) {
+            size_type cnt = 0;
+            for (ForwardIterator iter = first; iter != last && cnt < BATCH_SIZE; ++iter, ++cnt) {
+                const key_type& k = *iter;
+                hashes[cnt] = hash_(k);
+                positions[cnt] = policy_.index(hashes[cnt]);
+                mystd::prefetch(&buckets_[positions[cnt]]);
+            }
+            for (size_type i = 0; i < cnt; ++i) {
+                const bucket_type& bucket = buckets_[positions[i]];
+                if (!bucket.empty())
+                    mystd::prefetch(&bucket.front());
+            }
+            for (size_type i = 0; i < cnt; ++i, ++first) {
+                const key_type& k = *first;
+                *out++ = emit(locate(k, hashes[i]));
+            }
+        }
+        return out;
+    }
+
+    //n empty buckets, each built in place: copying even an empty forward_list needs a copyable T
+    static vector_type makeBuckets(size_type n, const allocator_type& alloc) {
+        vector_type buckets((bucket_allocator(alloc)));
+        buckets.reserve(n);
+        for (size_type i = 0; i < n; ++i)
+            buckets.emplace_back(node_allocator(alloc));
+        return buckets;
+    }
+
+    //grow, or move an incremental rehash along, before one element is added;
+    //the only place nodes migrate, so erasing never invalidates other iterators
+    void prepareInsert() {
+        std::pair<bool, size_type> need_rh = need_rehash(size() + 1);
+        if (need_rh.first) {
+            rehash(need_rh.second);
+        }
+        else {
+            migrateStep(rehash_step_);
+        }
+    }
+
+    //construct a new element at the front of its bucket; it must be absent and room prepared
+    template<typename... Args>
+    iterator emplaceNode(size_type hash, Args&&... args) {
+        const size_type pos = policy_.index(hash);
+        buckets_[pos].emplace_front(hash, std::forward<Args>(args)...);
+        ++size_;
+        return iterator(this, &buckets_, pos, buckets_[pos].cbegin());
+    }
+
+    template<typename V>
+    std::pair<iterator, bool> insertValue(V&& val) {
+        const size_type hash = hash_(val);
+        iterator iter = locate(val, hash);
+        //if the element exits
+        if (iter != end()) {
+            return std::make_pair(iter, false);
+        }
+        prepareInsert();
+        return std::make_pair(emplaceNode(hash, std::forward<V>(val)), true);
+    }
+
+    //k can be hashed and compared as it is
+    template<typename K>
+    std::pair<iterator, bool> tryEmplace(K&& k, std::true_type) {
+        const size_type hash = hash_(k);
+        iterator iter = locate(k, hash);
+        if (iter != end()) {
+            return std::make_pair(iter, false);
+        }
+        prepareInsert();
+        return std::make_pair(emplaceNode(hash, std::forward<K>(k)), true);
+    }
+
+    template<typename K>
+    std::pair<iterator, bool> tryEmplace(K&& k, std::false_type) {
+        return emplace(std::forward<K>(k));
+    }
+
+public:
+    /******constructor, destructor and copy******/
+    //default and empty
+    unordered_set() :unordered_set(static_cast<size_type>(0)) {}
+
+    explicit unordered_set(size_type n, const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& alloc = allocator_type()) :
+        hash_(hf), equal_(eql), buckets_(makeBuckets(policy_.bucket_count_for(n), alloc)),
+        old_buckets_(bucket_allocator(alloc)) {
+        policy_.set_bucket_count(buckets_.size());
+    }
+
+    explicit unordered_set(const allocator_type& alloc) :
+        unordered_set(static_cast<size_type>(0), hasher(), key_equal(), alloc) {}
+
+    //copy
+    unordered_set(const unordered_set& other) :
+        hash_(other.hash_), equal_(other.equal_), policy_(other.policy_), buckets_(other.buckets_), size_(other.size_), max_load_factor_(other.max_load_factor_),
+        old_policy_(other.old_policy_), old_buckets_(other.old_buckets_), migrate_pos_(other.migrate_pos_),
+        rehash_step_(other.rehash_step_) {}
+
+    //move
+    unordered_set(unordered_set&& other) noexcept {
+        swap(other);
+    }
+//TO DO: range, initializer list
+
+    unordered_set& operator=(const unordered_set& other) {
+        if (this == &other)
+            return *this;
+        unordered_set copy(other);
+        swap(copy);
+        return *this;
+    }
+
+    unordered_set& operator=(unordered_set&& other) noexcept {
+        if (this == &other)
+            return *this;
+        swap(other);
+        return *this;
+    }
+//TO DO: initializer list
+
+    ~unordered_set() = default;
+
+    allocator_type get_allocator() const {
+        return allocator_type(buckets_.get_allocator());
+    }
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return size_;
+    }
+
+    size_type max_size()const noexcept {
+        return policy_.max_bucket_count();
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /******Iterators******/
+    //container iterator
+    iterator begin() noexcept {
+        return const_iterator(this, false);
+    }
+
+    const_iterator begin()const noexcept {
+        return const_cast<unordered_set*>(this)->begin();
+    }
+
+    iterator end() noexcept {
+        return const_iterator(this, true);
+    }
+
+    const_iterator end()const noexcept {
+        return const_cast<unordered_set*>(this)->end();
+    }
+
+    const_iterator cbegin()const noexcept {
+        return begin();
+    }
+
+    const_iterator cend()const noexcept {
+        return end();
+    }
+
+    //bucket iterator
+    //Returns an iterator pointing to the first element in one of its buckets
+    local_iterator begin(size_type n) {
+        return local_iterator(buckets_[n].cbegin());
+    }
+
+    const_local_iterator begin(size_type n)const {
+        return const_local_iterator(buckets_[n].cbegin());
+    }
+
+    local_iterator end(size_type n) {
+        return local_iterator(buckets_[n].cend());
+    }
+
+    const_local_iterator end(size_type n)const {
+        return const_local_iterator(buckets_[n].cend());
+    }
+
+    const_local_iterator cbegin(size_type n)const {
+        return begin(n);
+    }
+
+    const_local_iterator cend(size_type n)const {
+        return end(n);
+    }
+
+    /******Element lookup******/
+    iterator find(const key_type& k) {
+        return locate(k, hash_(k));
+    }
+
+    const_iterator find(const key_type& k) const {
+        return const_cast<unordered_set*>(this)->find(k);
+    }
+
+    size_type count(const key_type& k) const {
+        if (locate(k, hash_(k)) != end()) return 1;
+        else return 0;
+    }
+
+    bool contains(const key_type& k) const {
+        return count(k) != 0;
+    }
+
+    //heterogeneous lookup, e.g. a std::string set searched with a string_view or a const char*
+    template<typename K, typename = typename std::enable_if<is_transparent_key<Hash, Equal, K>::value>::type>
+    iterator find(const K& k) {
+        return locate(k, hash_(k));
+    }
+
+    template<typename K, typename = typename std::enable_if<is_transparent_key<Hash, Equal, K>::value>::type>
+    const_iterator find(const K& k) const {
+        return locate(k, hash_(k));
+    }
+
+    template<typename K, typename = typename std::enable_if<is_transparent_key<Hash, Equal, K>::value>::type>
+    size_type count(const K& k) const {
+        if (locate(k, hash_(k)) != end()) return 1;
+        else return 0;
+    }
+
+    template<typename K, typename = typename std::enable_if<is_transparent_key<Hash, Equal, K>::value>::type>
+    bool contains(const K& k) const {
+        return count(k) != 0;
+    }
+
+    /*
+    find and contains for every key of [first, last), written to out in order; faster than a
+    loop of single lookups once the table is larger than the cache, see lookupBatch().
+    */
+    template<typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return lookupBatch(first, last, out, [](const_iterator iter) { return iter; });
+    }
+
+    template<typename ForwardIterator, typename OutputIterator>
+    OutputIterator contains_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        const const_iterator last_elem = end();
+        return lookupBatch(first, last, out, [&](const_iterator iter) { return iter != last_elem; });
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type& k) {
+        iterator ret = this->find(k);
+        return std::make_pair(ret, ret);
+    }
+
+    /******Modifiers******/
+//TO DO: insert(3)(4)(5)(6) in cpp reference
+
+    std::pair<iterator, bool> insert(const value_type& val) {
+        return insertValue(val);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& val) {
+        return insertValue(std::move(val));
+    }
+
+    //the element is built in its node first, to be hashed; if it is already present the node is dropped
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        bucket_type single((node_allocator(get_allocator())));
+        single.emplace_front(0, std::forward<Args>(args)...);
+        const size_type hash = hash_(single.front().value);
+        setHash(single.front(), hash, cache_tag());
+        iterator iter = locate(single.front().value, hash);
+        if (iter != end()) {
+            return std::make_pair(iter, false);
+        }
+
+        prepareInsert();
+        const size_type pos = policy_.index(hash);
+        buckets_[pos].splice_after(buckets_[pos].before_begin(), single, single.before_begin());
+        ++size_;
+        return std::make_pair(iterator(this, &buckets_, pos, buckets_[pos].cbegin()), true);
+    }
+
+    /*
+    Insert an element constructed from k, only if no equal element exists. With transparent
+    Hash and Equal, k is looked up as it is and value_type is only built on a miss.
+    */
+    template<typename K>
+    std::pair<iterator, bool> try_emplace(K&& k) {
+        using K_ = typename std::decay<K>::type;
+        return tryEmplace(std::forward<K>(k), std::integral_constant<bool,
+            is_transparent_key<Hash, Equal, K_>::value || std::is_same<K_, key_type>::value>());
+    }
+
+    iterator erase(const_iterator position) {
+        if (position == cend())
+            throw std::out_of_range("at mystd::unordered_set::erase()");
+
+        vector_type& table = position.ptr_ == &old_buckets_ ? old_buckets_ : buckets_;
+        bucket_type& bucket = table[position.bucket_idx_];
+        const node_iterator node = position.iter_;
+        ++position;
+
+        //unlink the node itself, nothing is copied or compared
+        node_iterator prev = bucket.cbefore_begin();
+        while (std::next(prev) != node)
+            ++prev;
+        bucket.erase_after(prev);
+        --size_;
+        return position;
+    }
+
+    size_type erase(const key_type& k) {
+        iterator iter = locate(k, hash_(k));
+        //if the element exits
+        if (iter == end()) {
+            return 0;
+        }
+        else {
+            erase(iter);
+            return 1;
+        }
+    }
+
+    template<typename K, typename = typename std::enable_if<is_transparent_key<Hash, Equal, K>::value &&
+        !std::is_convertible<const K&, const_iterator>::value>::type>
+    size_type erase(const K& k) {
+        iterator iter = locate(k, hash_(k));
+        if (iter == end()) {
+            return 0;
+        }
+        else {
+            erase(iter);
+            return 1;
+        }
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        const_iterator it = first;
+        while (it != last)
+            it = erase(it);
+        return last;
+    }
+
+    void swap(unordered_set& other) noexcept {
+        using std::swap;
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        buckets_.swap(other.buckets_);
+        swap(policy_, other.policy_);
+        swap(size_, other.size_);
+        swap(max_load_factor_, other.max_load_factor_);
+        swap(old_policy_, other.old_policy_);
+        old_buckets_.swap(other.old_buckets_);
+        swap(migrate_pos_, other.migrate_pos_);
+        swap(rehash_step_, other.rehash_step_);
+    }
+
+    //the bucket array is kept, only the elements are freed
+    void clear()noexcept {
+        for (bucket_type& bucket : buckets_)
+            bucket.clear();
+        old_buckets_.clear();
+        migrate_pos_ = 0;
+        size_ = 0;
+    }
+
+    /******Buckets******/
+    size_type bucket_count()const noexcept {
+        return buckets_.size();
+    }
+
+    size_type max_bucket_count()const noexcept {
+        return policy_.max_bucket_count();
+    }
+
+    //Returns the number of elements in bucket n
+    size_type bucket_size(size_type n) const {
+        return static_cast<size_type>(mystd::distance(buckets_[n].cbegin(), buckets_[n].cend()));
+    }
+
+    //Returns the bucket number where the element with value k is located
+    size_type bucket(const key_type& k) const {
+        return policy_.index(hash_(k));
+    }
+
+    /******Hash policy******/
+    float load_factor()const noexcept {
+        return static_cast<float>(size()) / static_cast<float>(bucket_count());
+    }
+
+    float max_load_factor() const noexcept {
+        return max_load_factor_;
+    }
+
+    void max_load_factor(float z) {
+        max_load_factor_ = z;
+    }
+
+    void rehash(size_type n) {
+        if (n < bucket_count())
+            return;
+        const size_type new_bucket_cnt = policy_.bucket_count_for(n);
+        if (new_bucket_cnt <= bucket_count())
+            return;
+        finishRehash();
+
+        //the current table becomes the old one and its nodes are relinked into the new one,
+        //all now or over the next operations
+        vector_type expanded = makeBuckets(new_bucket_cnt, get_allocator());
+        old_buckets_.swap(buckets_);
+        buckets_.swap(expanded);
+        old_policy_ = policy_;
+        policy_.set_bucket_count(new_bucket_cnt);
+        migrate_pos_ = 0;
+        migrateStep(rehash_step_ == 0 ? old_buckets_.size() : rehash_step_);
+    }
+
+    /*
+    Incremental rehash: with n > 0, growing the table no longer moves every element at once.
+    The old and new tables coexist, lookups search both, and every insert moves the
+    elements of the next n old buckets by relinking their nodes, so no single operation pays
+    for the whole rehash. Whatever is left when the table has to grow again is moved then.
+    0, the default, rehashes all at once. While rehashing, the bucket interface
+    (bucket(), bucket_size(), begin(n), ...) describes the new table only.
+    Only insert, emplace, reserve, rehash and rehash_step(0) move nodes, so while
+    rehashing() they invalidate every iterator, as a full rehash would; erase and the
+    lookups move nothing and invalidate only iterators to the erased elements.
+    */
+    void rehash_step(size_type n) {
+        rehash_step_ = n;
+        if (n == 0)
+            finishRehash();
+    }
+
+    size_type rehash_step() const noexcept {
+        return rehash_step_;
+    }
+
+    //an incremental rehash is in progress
+    bool rehashing() const noexcept {
+        return !old_buckets_.empty();
+    }
+
+    void reserve(size_type n) {
+        std::pair<bool, size_type> rh = need_rehash(n);
+        if (rh.first)
+            rehash(rh.second);
+    }
+
+private:
+    std::pair<bool, size_type> need_rehash(const size_type& next_size)const {
+        //refer to http://hustsxh.is-programmer.com/posts/82605.html
+        //need at least min buckets to contain size() + 1 elements
+        float min_bkts = static_cast<float>(next_size + 1) / max_load_factor_;
+        if (min_bkts > bucket_count()) {
+            min_bkts = mystd::max(min_bkts, growth_factor_ * size());
+            size_type next_resize = policy_.bucket_count_for(min_bkts);
+            return std::make_pair(true, next_resize);
+        }
+        return std::make_pair(false, 0);
+    }
+
+};
+
+}
+
+
+
+
@@ -1,341 +1,665 @@
-﻿#pragma once
-
-#include <memory>
-
-namespace mystd {
-using std::allocator;
-
-template<typename T>
-class vector {
-public:
-    using value_type =          T;
-    using pointer =             T*;
-    using const_pointer =       const T*;
-    using reference =           T&;
-    using const_reference =     const T&;
-    using iterator =            T*;
-    using const_iterator =      const T*;
-    using size_type =           std::size_t;
-    using difference_type =     std::ptrdiff_t;
-
-private:
-    const size_type INIT_CAPACITY = 1;
-    const size_type EXPAND_RATE = 2;
-
-private:
-    allocator<T> alloc_;
-    pointer elem_ = nullptr; //elements of vector
-    pointer end_ = nullptr; //point to position after last elem
-    pointer free_ = nullptr; //the first space after capacity pf vector
-
-private:
-    void destroyElem(iterator begin, iterator end) {
-        for (iterator it = begin; it < end; ++it)
-            alloc_.destroy(it);
-    }
-
-    //destroy elements and free the space
-    void clearMem() {
-        if (elem_) {
-            destroyElem(elem_, end_);
-            alloc_.deallocate(elem_, capacity());
-            elem_ = free_ = end_ = nullptr;
-        }
-    }
-
-    void expandCapacity(size_type new_capacity) {
-        if (new_capacity <= capacity())
-            return;
-
-        pointer new_elem_ = nullptr, new_end_, new_free_;
-        try {
-            new_elem_ = alloc_.allocate(new_capacity);
-        }
-        catch (...) {
-            alloc_.deallocate(new_elem_, new_capacity);
-            throw;
-        }
-        new_end_ = new_elem_ + size();
-        new_free_ = new_elem_ + new_capacity;
-        std::uninitialized_copy(elem_, end_, new_elem_);
-        clearMem();
-        elem_ = new_elem_;
-        end_ = new_end_;
-        free_ = new_free_;
-    }
-
-    void checkCapacity() {
-        if (end_ == free_)
-            expandCapacity(empty() ? INIT_CAPACITY : capacity() * EXPAND_RATE);
-    }
-
-public:
-    /******constructor******/
-    //default
-    explicit vector() = default;
-
-    //fill
-    explicit vector(size_type n, const value_type& val = value_type()) {
-        try {
-            elem_ = alloc_.allocate(n);
-        }
-        catch (...) {
-            alloc_.deallocate(elem_, n);
-            throw;
-        }
-        std::uninitialized_fill_n(elem_, n, val);
-        end_ = free_ = elem_ + n;
-    }
-
-    //to simplify my vector, it only requires vector::iterator
-    vector(const_iterator first, const_iterator last) {
-        if (first == nullptr && last == nullptr)
-            return;
-        if (first > last)
-            throw std::out_of_range("at vector()");
-
-        difference_type n = std::distance(first, last);
-        pointer new_elem_;
-        new_elem_ = alloc_.allocate(n);
-        try {
-            std::uninitialized_copy(first, last, new_elem_);
-        }
-        catch (...) {
-            alloc_.deallocate(new_elem_, n);
-            throw;
-        }
-
-        clearMem();
-        elem_ = new_elem_;
-        end_ = free_ = elem_ + n;
-    }
-
-    vector(const vector& other) : vector(other.cbegin(), other.cend()) {}
-
-    vector(vector&& other) noexcept {
-        swap(other);
-    }
-
-    vector& operator=(const vector& other) {
-        if (&other == this)
-            return *this;
-        vector copy(other);
-        swap(copy);
-        return *this;
-    }
-
-    vector& operator=(vector&& other) {
-        if (&other == this)
-            return *this;
-        swap(other);
-        return *this;
-    }
-
-    //TO DO: construct with an initializer_list
-
-    /******Destructor******/
-    ~vector() {
-        clearMem();
-    }
-
-
-    /******Capacity******/
-    size_type size() const noexcept {
-        return end_ - elem_;
-    }
-
-    size_type capacity() const noexcept {
-        return free_ - elem_;
-    }
-
-    bool empty() const noexcept {
-        return end_ == elem_;
-    }
-
-    void reserve(size_type n) {
-        expandCapacity(n);
-    }
-
-    void resize(size_type n) {
-        resize(n, value_type());
-    }
-
-    void resize(size_type n, const value_type& val) {
-        if (n < size()) {
-            erase(begin() + n, end());
-        }
-        else if (n > size()) {
-            insert(end(), size() - n, val);
-        }
-    }
-    //TO DO:
-
-    /******Element access******/
-    reference operator[](size_type index) {
-        return elem_[index];
-    }
-
-    const_reference operator[](size_type index) const {
-        return const_cast<vector*>(this)->operator[](index);
-    }
-
-    reference at(size_type index) {
-        if (index >= size())
-            throw std::out_of_range("at operator[]");
-        return this->operator[](index);
-    }
-
-    const_reference at(size_type index) const {
-        return const_cast<vector*>(this)->at(index);
-    }
-
-    reference front() {
-        return *begin();
-    }
-
-    const_reference front() const{
-        return const_cast<vector*>(this)->front();
-    }
-
-    reference back() {
-        if (!elem_)
-            throw std::out_of_range("at back()");
-        return *(end_ - 1);
-    }
-
-    const_reference back() const{
-        if (!elem_)
-            throw std::out_of_range("at back()");
-        return const_cast<vector*>(this)->back();
-    }
-
-    //TO DO: const_reference versions
-
-    /******iterator******/
-    iterator begin() noexcept {
-        return elem_;
-    }
-
-    const_iterator begin() const noexcept {
-        return elem_;
-    }
-
-    const_iterator cbegin() const noexcept {
-        return elem_;
-    }
-
-    iterator end() noexcept {
-        return end_;
-    }
-
-    const_iterator end() const noexcept {
-        return end_;
-    }
-
-    const_iterator cend() const noexcept {
-        return end_;
-    }
-    //TO DO: rbegin, rend
-
-    /******Modifiers******/
-    void push_back(const value_type& val) {
-        checkCapacity();
-        alloc_.construct(end_, val);
-        ++end_;
-    }
-
-    void push_back(value_type&& val) {
-        checkCapacity();
-        new(end_) value_type(std::move(val));
-        ++end_;
-    }
-
-    void pop_back() {
-        if (empty())
-            throw std::out_of_range("at pop_back()");
-        alloc_.destroy(end_);
-        --end_;
-    }
-
-    iterator insert(const_iterator position, const value_type& val) {
-        value_type val_ = val;
-        return insert(position, std::move(val_));
-    }
-
-    iterator insert(const_iterator position, size_type n, const value_type& val) {
-        iterator non_const_pos = const_cast<iterator>(position);
-        if (n == 0)
-            return non_const_pos;
-        for (size_type i = 0; i < n; ++i) {
-            non_const_pos = insert(non_const_pos, val);
-        }
-        return non_const_pos;
-    }
-
-    iterator insert(const_iterator position, value_type&& val) {
-        if (position < cbegin() || position > cend()) {
-            throw std::out_of_range("at insert()");
-        }
-        //if vector is expanded, position will be valid
-        difference_type idx = position - cbegin();
-        checkCapacity();
-        iterator non_const_pos = begin() + idx;
-
-        if (non_const_pos == end()) {
-            alloc_.construct(end_, val);
-            iterator ret = end();
-            ++end_;
-            return ret;
-        }
-
-        alloc_.construct(end_, *(end_ - 1));
-        ++end_;
-        for (iterator it = end() - 2; it > non_const_pos; --it) {
-            *it = std::move(*(it - 1));
-        }
-        *non_const_pos = val;
-        return non_const_pos;
-    }
-
-    //[first, last)
-    iterator erase(const_iterator first, const_iterator last) {
-        if (empty() || first < cbegin() || last > cend())
-            throw std::out_of_range("at erase()");
-
-        if (last == cend()) {
-            destroyElem(const_cast<iterator>(first), end_);
-            end_ = const_cast<iterator>(first);
-            return end();
-        }
-
-        iterator iter = std::move(const_cast<iterator>(last), end_, const_cast<iterator>(first));
-        destroyElem(iter, end_);
-        end_ = iter;
-        return const_cast<iterator>(first);
-    }
-
-    iterator erase(const_iterator position) {
-        if (position == cend()) {
-            alloc_.destroy(--end_);
-            return end();
-        }
-        return erase(position, position + 1);
-    }
-
-    void clear() noexcept {
-        if (empty())
-            throw std::out_of_range("at clear()");
-        destroyElem(elem_, end_);
-        end_ = elem_;
-    }
-
-    void swap(vector& other) {
-        std::swap(elem_, other.elem_);
-        std::swap(end_, other.end_);
-        std::swap(free_, other.free_);
-    }
-
-    //TO DO: insert(range), assign
-};
-
-}
+﻿#pragma once
+
+#include <memory>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include "iterator.h"
+
+namespace mystd {
+using std::allocator;
+
+//A type is trivially relocatable if moving it to a new address and forgetting the old one
+//can be done by a plain memcpy. Specialize it for your own types (e.g. a pointer-owning buffer
+//without self references) to let containers grow and shift them with memcpy/memmove.
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+//The element shifting and relocation shared by vector and small_vector. Derived owns
+//alloc_, elem_, end_ and free_, and provides capacity(), emplace_back() and
+//adoptStorage(new_elem, new_size, new_capacity), which frees the old buffer for new_elem.
+template<typename Derived, typename T, typename Allocator>
+class vector_base {
+    friend Derived;
+
+    using pointer =             T*;
+    using iterator =            T*;
+    using size_type =           std::size_t;
+    using difference_type =     std::ptrdiff_t;
+    using alloc_traits =        std::allocator_traits<Allocator>;
+
+    static const size_type EXPAND_RATE = 2;
+
+    using relocate_tag = std::integral_constant<bool, is_trivially_relocatable<T>::value>;
+    //move if it won't throw, otherwise copy, so that a failed growth leaves *this unchanged
+    using move_tag = std::integral_constant<bool,
+        std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value>;
+
+    Derived& self() noexcept {
+        return static_cast<Derived&>(*this);
+    }
+
+    void destroyElem(iterator begin, iterator end) {
+        for (iterator it = begin; it < end; ++it)
+            alloc_traits::destroy(self().alloc_, it);
+    }
+
+    static void uninitializedMove(iterator first, iterator last, iterator dest, std::true_type) {
+        std::uninitialized_copy(std::make_move_iterator(first), std::make_move_iterator(last), dest);
+    }
+
+    static void uninitializedMove(iterator first, iterator last, iterator dest, std::false_type) {
+        std::uninitialized_copy(first, last, dest);
+    }
+
+    //construct [first, last) in uninitialized memory at dest, then destroy [first, last)
+    void relocate(iterator first, iterator last, iterator dest, std::true_type) {
+        if (first != last)
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), (last - first) * sizeof(T));
+    }
+
+    void relocate(iterator first, iterator last, iterator dest, std::false_type) {
+        uninitializedMove(first, last, dest, move_tag());
+        destroyElem(first, last);
+    }
+
+    //Insert n elements before position, shifting the tail only once.
+    //construct(dest) builds the n new elements in the uninitialized space [dest, dest + n)
+    //and must destroy whatever it built if it throws.
+    template<typename Construct>
+    iterator insertN(iterator position, size_type n, Construct construct) {
+        if (n == 0)
+            return position;
+        Derived& d = self();
+        const size_type idx = position - d.elem_;
+        const size_type size = d.end_ - d.elem_;
+
+        //reallocate only when the spare capacity is too small
+        if (n <= size_type(d.free_ - d.end_)) {
+            if (position == d.end_) {
+                construct(position);
+                d.end_ += n;
+                return position;
+            }
+            if (relocate_tag::value || std::is_nothrow_move_constructible<T>::value) {
+                shiftBackward(position, n, relocate_tag());
+                try {
+                    construct(position);
+                }
+                catch (...) {
+                    shiftForward(position, n, relocate_tag());
+                    throw;
+                }
+                d.end_ += n;
+                return position;
+            }
+            //the tail can't be moved without risk: build the new elements behind it and rotate
+            //them into place, which leaves every element alive, though unordered, if a move throws
+            const iterator old_end = d.end_;
+            construct(old_end);
+            d.end_ += n;
+            std::rotate(position, old_end, d.end_);
+            return position;
+        }
+
+        size_type new_capacity = d.capacity() * EXPAND_RATE;
+        if (new_capacity < size + n)
+            new_capacity = size + n;
+        pointer new_elem_ = alloc_traits::allocate(d.alloc_, new_capacity);
+        pointer new_pos = new_elem_ + idx;
+        try {
+            construct(new_pos);
+        }
+        catch (...) {
+            alloc_traits::deallocate(d.alloc_, new_elem_, new_capacity);
+            throw;
+        }
+        try {
+            transferAround(position, n, new_elem_, relocate_tag());
+        }
+        catch (...) {
+            destroyElem(new_pos, new_pos + n);
+            alloc_traits::deallocate(d.alloc_, new_elem_, new_capacity);
+            throw;
+        }
+        d.adoptStorage(new_elem_, size + n, new_capacity);
+        return new_pos;
+    }
+
+    //move [position, end_) to [position + n, end_ + n), leaving [position, position + n) uninitialized
+    void shiftBackward(iterator position, size_type n, std::true_type) {
+        std::memmove(static_cast<void*>(position + n), static_cast<const void*>(position),
+            (self().end_ - position) * sizeof(T));
+    }
+
+    void shiftBackward(iterator position, size_type n, std::false_type) {
+        Derived& d = self();
+        for (iterator it = d.end_; it != position;) {
+            --it;
+            //a target inside the old range has already been moved from
+            if (it + n < d.end_)
+                alloc_traits::destroy(d.alloc_, it + n);
+            alloc_traits::construct(d.alloc_, it + n, std::move(*it));
+        }
+        destroyElem(position, position + n < d.end_ ? position + n : d.end_);
+    }
+
+    //undo shiftBackward
+    void shiftForward(iterator position, size_type n, std::true_type) {
+        std::memmove(static_cast<void*>(position), static_cast<const void*>(position + n),
+            (self().end_ - position) * sizeof(T));
+    }
+
+    void shiftForward(iterator position, size_type n, std::false_type) {
+        Derived& d = self();
+        for (iterator it = position + n; it != d.end_ + n; ++it) {
+            alloc_traits::construct(d.alloc_, it - n, std::move(*it));
+            alloc_traits::destroy(d.alloc_, it);
+        }
+    }
+
+    //put [elem_, position) and [position, end_) into new_elem around a gap of n elements
+    void transferAround(iterator position, size_type n, pointer new_elem, std::true_type) {
+        Derived& d = self();
+        relocate(d.elem_, position, new_elem, std::true_type());
+        relocate(position, d.end_, new_elem + (position - d.elem_) + n, std::true_type());
+    }
+
+    //the old elements stay intact until both halves are in place
+    void transferAround(iterator position, size_type n, pointer new_elem, std::false_type) {
+        Derived& d = self();
+        uninitializedMove(d.elem_, position, new_elem, move_tag());
+        try {
+            uninitializedMove(position, d.end_, new_elem + (position - d.elem_) + n, move_tag());
+        }
+        catch (...) {
+            destroyElem(new_elem, new_elem + (position - d.elem_));
+            throw;
+        }
+        destroyElem(d.elem_, d.end_);
+    }
+
+    template<typename ForwardIterator>
+    iterator insertRange(iterator position, ForwardIterator first, ForwardIterator last, std::true_type) {
+        const size_type n = mystd::distance(first, last);
+        return insertN(position, n, [&](pointer dest) { std::uninitialized_copy(first, last, dest); });
+    }
+
+    //a single pass range has to be buffered to learn its length
+    template<typename InputIterator>
+    iterator insertRange(iterator position, InputIterator first, InputIterator last, std::false_type) {
+        Derived& d = self();
+        if (position == d.end_) {
+            const difference_type idx = position - d.elem_;
+            for (; first != last; ++first)
+                d.emplace_back(*first);
+            return d.elem_ + idx;
+        }
+        Derived buffer(d.alloc_);
+        for (; first != last; ++first)
+            buffer.emplace_back(*first);
+        return insertRange(position, std::make_move_iterator(buffer.begin()),
+            std::make_move_iterator(buffer.end()), std::true_type());
+    }
+
+    iterator shiftErase(iterator first, iterator last, std::true_type) {
+        Derived& d = self();
+        destroyElem(first, last);
+        std::memmove(static_cast<void*>(first), static_cast<const void*>(last), (d.end_ - last) * sizeof(T));
+        d.end_ -= last - first;
+        return first;
+    }
+
+    iterator shiftErase(iterator first, iterator last, std::false_type) {
+        //an empty range would move every element of the tail onto itself
+        if (first == last)
+            return first;
+        Derived& d = self();
+        iterator iter = std::move(last, d.end_, first);
+        destroyElem(iter, d.end_);
+        d.end_ = iter;
+        return first;
+    }
+};
+
+template<typename T, typename Allocator = allocator<T>>
+class vector : private vector_base<vector<T, Allocator>, T, Allocator> {
+    using base = vector_base<vector<T, Allocator>, T, Allocator>;
+    friend base;
+
+public:
+    using value_type =          T;
+    using allocator_type =      Allocator;
+    using pointer =             T*;
+    using const_pointer =       const T*;
+    using reference =           T&;
+    using const_reference =     const T&;
+    using iterator =            T*;
+    using const_iterator =      const T*;
+    using size_type =           std::size_t;
+    using difference_type =     std::ptrdiff_t;
+
+private:
+    const size_type INIT_CAPACITY = 1;
+    using base::EXPAND_RATE;
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using relocate_tag = typename base::relocate_tag;
+    using base::destroyElem;
+    using base::relocate;
+    using base::insertN;
+    using base::insertRange;
+    using base::shiftErase;
+
+    Allocator alloc_;
+    pointer elem_ = nullptr; //elements of vector
+    pointer end_ = nullptr; //point to position after last elem
+    pointer free_ = nullptr; //the first space after capacity pf vector
+
+private:
+    //destroy elements and free the space
+    void clearMem() {
+        if (elem_) {
+            destroyElem(elem_, end_);
+            alloc_traits::deallocate(alloc_, elem_, capacity());
+            elem_ = free_ = end_ = nullptr;
+        }
+    }
+
+    //switch to the buffer new_elem of new_capacity, which already holds new_size elements
+    void adoptStorage(pointer new_elem, size_type new_size, size_type new_capacity) {
+        if (elem_)
+            alloc_traits::deallocate(alloc_, elem_, capacity());
+        elem_ = new_elem;
+        end_ = new_elem + new_size;
+        free_ = new_elem + new_capacity;
+    }
+
+    void expandCapacity(size_type new_capacity) {
+        if (new_capacity <= capacity())
+            return;
+
+        pointer new_elem_ = nullptr, new_end_, new_free_;
+        try {
+            new_elem_ = alloc_traits::allocate(alloc_, new_capacity);
+        }
+        catch (...) {
+            alloc_traits::deallocate(alloc_, new_elem_, new_capacity);
+            throw;
+        }
+        new_end_ = new_elem_ + size();
+        new_free_ = new_elem_ + new_capacity;
+        try {
+            relocate(elem_, end_, new_elem_, relocate_tag());
+        }
+        catch (...) {
+            alloc_traits::deallocate(alloc_, new_elem_, new_capacity);
+            throw;
+        }
+        if (elem_)
+            alloc_traits::deallocate(alloc_, elem_, capacity());
+        elem_ = new_elem_;
+        end_ = new_end_;
+        free_ = new_free_;
+    }
+
+    void checkCapacity() {
+        if (end_ == free_)
+            expandCapacity(empty() ? INIT_CAPACITY : capacity() * EXPAND_RATE);
+    }
+
+public:
+    /******constructor******/
+    //default
+    explicit vector() = default;
+
+    explicit vector(const allocator_type& alloc) : alloc_(alloc) {}
+
+    //fill
+    explicit vector(size_type n, const value_type& val = value_type(),
+        const allocator_type& alloc = allocator_type()) : alloc_(alloc) {
+        try {
+            elem_ = alloc_traits::allocate(alloc_, n);
+        }
+        catch (...) {
+            alloc_traits::deallocate(alloc_, elem_, n);
+            throw;
+        }
+        std::uninitialized_fill_n(elem_, n, val);
+        end_ = free_ = elem_ + n;
+    }
+
+    //to simplify my vector, it only requires vector::iterator
+    vector(const_iterator first, const_iterator last, const allocator_type& alloc = allocator_type()) : alloc_(alloc) {
+        if (first == nullptr && last == nullptr)
+            return;
+        if (first > last)
+            throw std::out_of_range("at vector()");
+
+        difference_type n = std::distance(first, last);
+        pointer new_elem_;
+        new_elem_ = alloc_traits::allocate(alloc_, n);
+        try {
+            std::uninitialized_copy(first, last, new_elem_);
+        }
+        catch (...) {
+            alloc_traits::deallocate(alloc_, new_elem_, n);
+            throw;
+        }
+
+        clearMem();
+        elem_ = new_elem_;
+        end_ = free_ = elem_ + n;
+    }
+
+    vector(const vector& other) :
+        vector(other.cbegin(), other.cend(), alloc_traits::select_on_container_copy_construction(other.alloc_)) {}
+
+    vector(vector&& other) noexcept : alloc_(other.alloc_) {
+        swap(other);
+    }
+
+    vector& operator=(const vector& other) {
+        if (&other == this)
+            return *this;
+        vector copy(other);
+        swap(copy);
+        return *this;
+    }
+
+    vector& operator=(vector&& other) {
+        if (&other == this)
+            return *this;
+        swap(other);
+        return *this;
+    }
+
+    //TO DO: construct with an initializer_list
+
+    /******Destructor******/
+    ~vector() {
+        clearMem();
+    }
+
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+
+    /******Capacity******/
+    size_type size() const noexcept {
+        return end_ - elem_;
+    }
+
+    size_type capacity() const noexcept {
+        return free_ - elem_;
+    }
+
+    bool empty() const noexcept {
+        return end_ == elem_;
+    }
+
+    void reserve(size_type n) {
+        expandCapacity(n);
+    }
+
+    void resize(size_type n) {
+        resize(n, value_type());
+    }
+
+    void resize(size_type n, const value_type& val) {
+        if (n < size()) {
+            erase(begin() + n, end());
+        }
+        else if (n > size()) {
+            insert(end(), n - size(), val);
+        }
+    }
+    //TO DO:
+
+    /******Element access******/
+    reference operator[](size_type index) {
+        return elem_[index];
+    }
+
+    const_reference operator[](size_type index) const {
+        return const_cast<vector*>(this)->operator[](index);
+    }
+
+    reference at(size_type index) {
+        if (index >= size())
+            throw std::out_of_range("at operator[]");
+        return this->operator[](index);
+    }
+
+    const_reference at(size_type index) const {
+        return const_cast<vector*>(this)->at(index);
+    }
+
+    reference front() {
+        return *begin();
+    }
+
+    const_reference front() const{
+        return const_cast<vector*>(this)->front();
+    }
+
+    reference back() {
+        if (!elem_)
+            throw std::out_of_range("at back()");
+        return *(end_ - 1);
+    }
+
+    const_reference back() const{
+        if (!elem_)
+            throw std::out_of_range("at back()");
+        return const_cast<vector*>(this)->back();
+    }
+
+    //TO DO: const_reference versions
+
+    /******iterator******/
+    iterator begin() noexcept {
+        return elem_;
+    }
+
+    const_iterator begin() const noexcept {
+        return elem_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return elem_;
+    }
+
+    iterator end() noexcept {
+        return end_;
+    }
+
+    const_iterator end() const noexcept {
+        return end_;
+    }
+
+    const_iterator cend() const noexcept {
+        return end_;
+    }
+    //TO DO: rbegin, rend
+
+    /******Modifiers******/
+    void push_back(const value_type& val) {
+        emplace_back(val);
+    }
+
+    void push_back(value_type&& val) {
+        emplace_back(std::move(val));
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        if (end_ != free_) {
+            alloc_traits::construct(alloc_, end_, std::forward<Args>(args)...);
+            ++end_;
+        }
+        else {
+            //the new element is built before the old ones are relocated, so args may refer into *this
+            insertN(end_, 1, [&](pointer dest) { alloc_traits::construct(alloc_, dest, std::forward<Args>(args)...); });
+        }
+        return back();
+    }
+
+    void pop_back() {
+        if (empty())
+            throw std::out_of_range("at pop_back()");
+        alloc_traits::destroy(alloc_, --end_);
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator position, Args&&... args) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at emplace()");
+        if (position == cend()) {
+            const difference_type idx = position - cbegin();
+            emplace_back(std::forward<Args>(args)...);
+            return begin() + idx;
+        }
+        //args may refer to an element that is about to be shifted
+        value_type val(std::forward<Args>(args)...);
+        return insert(position, std::move(val));
+    }
+
+    iterator insert(const_iterator position, const value_type& val) {
+        value_type val_ = val;
+        return insert(position, std::move(val_));
+    }
+
+    iterator insert(const_iterator position, size_type n, const value_type& val) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at insert()");
+        const value_type copy = val;
+        return insertN(const_cast<iterator>(position), n,
+            [&](pointer dest) { std::uninitialized_fill_n(dest, n, copy); });
+    }
+
+    iterator insert(const_iterator position, value_type&& val) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at insert()");
+        return insertN(const_cast<iterator>(position), 1,
+            [&](pointer dest) { alloc_traits::construct(alloc_, dest, std::move(val)); });
+    }
+
+    //[first, last)
+    template<typename InputIterator,
+        typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    iterator insert(const_iterator position, InputIterator first, InputIterator last) {
+        if (position < cbegin() || position > cend())
+            throw std::out_of_range("at insert()");
+        return insertRange(const_cast<iterator>(position), first, last,
+            std::integral_constant<bool, is_forward_iterator<InputIterator>::value>());
+    }
+
+    void assign(size_type n, const value_type& val) {
+        if (n > capacity()) {
+            vector filled(n, val, alloc_);
+            swap(filled);
+            return;
+        }
+        const value_type copy = val;
+        if (n > size()) {
+            std::fill(elem_, end_, copy);
+            std::uninitialized_fill_n(end_, n - size(), copy);
+        }
+        else {
+            std::fill_n(elem_, n, copy);
+            destroyElem(elem_ + n, end_);
+        }
+        end_ = elem_ + n;
+    }
+
+    template<typename InputIterator,
+        typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    void assign(InputIterator first, InputIterator last) {
+        assignRange(first, last, std::integral_constant<bool, is_forward_iterator<InputIterator>::value>());
+    }
+
+    //[first, last)
+    iterator erase(const_iterator first, const_iterator last) {
+        if (empty() || first < cbegin() || last > cend())
+            throw std::out_of_range("at erase()");
+
+        if (last == cend()) {
+            destroyElem(const_cast<iterator>(first), end_);
+            end_ = const_cast<iterator>(first);
+            return end();
+        }
+
+        return shiftErase(const_cast<iterator>(first), const_cast<iterator>(last), relocate_tag());
+    }
+
+    iterator erase(const_iterator position) {
+        if (position == cend()) {
+            alloc_traits::destroy(alloc_, --end_);
+            return end();
+        }
+        return erase(position, position + 1);
+    }
+
+    void clear() noexcept {
+        destroyElem(elem_, end_);
+        end_ = elem_;
+    }
+
+    void swap(vector& other) {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+        std::swap(elem_, other.elem_);
+        std::swap(end_, other.end_);
+        std::swap(free_, other.free_);
+    }
+
+private:
+    template<typename ForwardIterator>
+    void assignRange(ForwardIterator first, ForwardIterator last, std::true_type) {
+        const size_type n = mystd::distance(first, last);
+        if (n > capacity()) {
+            pointer new_elem_ = alloc_traits::allocate(alloc_, n);
+            try {
+                std::uninitialized_copy(first, last, new_elem_);
+            }
+            catch (...) {
+                alloc_traits::deallocate(alloc_, new_elem_, n);
+                throw;
+            }
+            clearMem();
+            elem_ = new_elem_;
+            end_ = free_ = new_elem_ + n;
+            return;
+        }
+        iterator it = elem_;
+        for (; it != end_ && first != last; ++it, ++first)
+            *it = *first;
+        if (first != last)
+            std::uninitialized_copy(first, last, end_);
+        else
+            destroyElem(it, end_);
+        end_ = elem_ + n;
+    }
+
+    template<typename InputIterator>
+    void assignRange(InputIterator first, InputIterator last, std::false_type) {
+        iterator it = elem_;
+        for (; it != end_ && first != last; ++it, ++first)
+            *it = *first;
+        if (first == last) {
+            destroyElem(it, end_);
+            end_ = it;
+        }
+        else {
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+    }
+
+};
+
+}